@@ -0,0 +1,477 @@
+#include "provided.h"
+#include "ContractionHierarchy.h"
+#include "SearchWorkspace.h"
+#include <vector>
+#include <queue>
+#include <limits>
+#include <algorithm>
+#include <functional>
+using namespace std;
+
+namespace {
+
+const double INFINITE_WEIGHT = numeric_limits<double>::infinity();
+
+}
+
+ContractionHierarchy::ContractionHierarchy(const StreetGraph& graph)
+ : m_graph(graph)
+{
+    contract();
+
+    //every edge belongs to the arc between its endpoints
+    m_edgeArcs.assign(graph.numEdges(), -1);
+    for(EdgeID e = 0; e < graph.numEdges(); e++){
+        NodeID a = graph.source(e);
+        NodeID b = graph.target(e);
+        if(a == b){
+            continue; //a loop never helps a shortest path
+        }
+        NodeID low = m_rank[a] < m_rank[b] ? a : b;
+        NodeID high = low == a ? b : a;
+        for(int arc = m_arcOffsets[low]; arc < m_arcOffsets[low + 1]; arc++){
+            if(m_targets[arc] == high){
+                m_edgeArcs[e] = arc;
+                break;
+            }
+        }
+    }
+
+    indexArcs();
+
+    vector<double> weights(graph.numEdges());
+    for(EdgeID e = 0; e < graph.numEdges(); e++){
+        weights[e] = graph.weight(e);
+    }
+    customize(weights.data());
+}
+
+namespace {
+
+  //CSR lists from (list, item) pairs; items keep their order within a list
+void groupBy(int numLists, const vector<int>& lists, const vector<int>& items, vector<int>& offsets, vector<int>& grouped)
+{
+    offsets.assign(numLists + 1, 0);
+    for(size_t i = 0; i < lists.size(); i++){
+        offsets[lists[i] + 1]++;
+    }
+    for(int l = 0; l < numLists; l++){
+        offsets[l + 1] += offsets[l];
+    }
+    grouped.resize(items.size());
+    vector<int> next(offsets.begin(), offsets.end() - 1);
+    for(size_t i = 0; i < lists.size(); i++){
+        grouped[next[lists[i]]++] = items[i];
+    }
+}
+
+}
+
+void ContractionHierarchy::indexArcs()
+{
+    int numArcs = m_targets.size();
+    vector<int> lists, items;
+    for(EdgeID e = 0; e < m_graph.numEdges(); e++){
+        if(m_edgeArcs[e] != -1){
+            lists.push_back(m_edgeArcs[e]);
+            items.push_back(e);
+        }
+    }
+    groupBy(numArcs, lists, items, m_arcEdgeOffsets, m_arcEdges);
+
+    int numTriangles = m_triangleLower.size();
+    vector<int> triangles(numTriangles);
+    for(int t = 0; t < numTriangles; t++){
+        triangles[t] = t;
+    }
+    groupBy(numArcs, m_triangleUpper, triangles, m_relaxingOffsets, m_relaxing);
+
+    lists = m_triangleLower;
+    lists.insert(lists.end(), m_triangleMiddle.begin(), m_triangleMiddle.end());
+    items = triangles;
+    items.insert(items.end(), triangles.begin(), triangles.end());
+    groupBy(numArcs, lists, items, m_relaxedOffsets, m_relaxed);
+}
+
+void ContractionHierarchy::contract()
+{
+    int numNodes = m_graph.numNodes();
+
+    //undirected neighbor sets, without loops or parallel edges
+    vector<vector<NodeID> > neighbors(numNodes);
+    for(EdgeID e = 0; e < m_graph.numEdges(); e++){
+        NodeID a = m_graph.source(e);
+        NodeID b = m_graph.target(e);
+        if(a != b && find(neighbors[a].begin(), neighbors[a].end(), b) == neighbors[a].end()){
+            neighbors[a].push_back(b);
+            neighbors[b].push_back(a);
+        }
+    }
+
+    //repeatedly contract the node with the fewest remaining neighbors, turning its neighborhood into a clique
+    typedef pair<int, NodeID> Candidate;
+    priority_queue<Candidate, vector<Candidate>, greater<Candidate> > candidates;
+    for(NodeID n = 0; n < numNodes; n++){
+        candidates.push(Candidate(neighbors[n].size(), n));
+    }
+
+    m_rank.assign(numNodes, -1);
+    vector<NodeID> order;
+    vector<vector<NodeID> > upward(numNodes);
+    while(!candidates.empty()){
+        Candidate c = candidates.top();
+        candidates.pop();
+        NodeID v = c.second;
+        if(m_rank[v] != -1 || c.first != (int)neighbors[v].size()){
+            continue; //stale entry
+        }
+        m_rank[v] = order.size();
+        order.push_back(v);
+
+        vector<NodeID>& nb = neighbors[v];
+        upward[v] = nb;
+        for(size_t i = 0; i < nb.size(); i++){
+            vector<NodeID>& other = neighbors[nb[i]];
+            other.erase(find(other.begin(), other.end(), v));
+        }
+        for(size_t i = 0; i < nb.size(); i++){
+            for(size_t j = i + 1; j < nb.size(); j++){
+                vector<NodeID>& a = neighbors[nb[i]];
+                if(find(a.begin(), a.end(), nb[j]) == a.end()){
+                    a.push_back(nb[j]);
+                    neighbors[nb[j]].push_back(nb[i]);
+                }
+            }
+        }
+        for(size_t i = 0; i < nb.size(); i++){
+            candidates.push(Candidate(neighbors[nb[i]].size(), nb[i]));
+        }
+        nb.clear();
+        nb.shrink_to_fit();
+    }
+
+    //upward arcs in CSR form, each node's arcs sorted by the rank of their head
+    m_arcOffsets.assign(numNodes + 1, 0);
+    for(NodeID n = 0; n < numNodes; n++){
+        vector<NodeID>& up = upward[n];
+        sort(up.begin(), up.end(), [this](NodeID a, NodeID b) { return m_rank[a] < m_rank[b]; });
+        m_arcOffsets[n + 1] = m_arcOffsets[n] + up.size();
+        for(size_t i = 0; i < up.size(); i++){
+            m_sources.push_back(n);
+            m_targets.push_back(up[i]);
+        }
+    }
+
+    //lower triangles, grouped by their lowest node in contraction order
+    for(size_t r = 0; r < order.size(); r++){
+        NodeID v = order[r];
+        for(int lower = m_arcOffsets[v]; lower < m_arcOffsets[v + 1]; lower++){
+            NodeID u = m_targets[lower];
+            for(int middle = lower + 1; middle < m_arcOffsets[v + 1]; middle++){
+                NodeID w = m_targets[middle];
+                for(int upper = m_arcOffsets[u]; upper < m_arcOffsets[u + 1]; upper++){
+                    if(m_targets[upper] == w){
+                        m_triangleLower.push_back(lower);
+                        m_triangleMiddle.push_back(middle);
+                        m_triangleUpper.push_back(upper);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void ContractionHierarchy::customize(const double* weights)
+{
+    int numArcs = m_targets.size();
+    m_up.assign(numArcs, INFINITE_WEIGHT);
+    m_down.assign(numArcs, INFINITE_WEIGHT);
+    m_upEdge.assign(numArcs, NO_EDGE);
+    m_downEdge.assign(numArcs, NO_EDGE);
+    m_upTriangle.assign(numArcs, -1);
+    m_downTriangle.assign(numArcs, -1);
+
+    //start from the cheapest segment in each direction
+    for(EdgeID e = 0; e < m_graph.numEdges(); e++){
+        relaxEdge(e, weights);
+    }
+
+    //bottom-up, so the two lower arcs of a triangle are final before they relax the upper one
+    int numTriangles = m_triangleLower.size();
+    for(int t = 0; t < numTriangles; t++){
+        relaxTriangle(t);
+    }
+}
+
+void ContractionHierarchy::relaxEdge(EdgeID e, const double* weights)
+{
+    int arc = m_edgeArcs[e];
+    if(arc == -1){
+        return;
+    }
+    if(m_graph.source(e) == m_sources[arc]){
+        if(weights[e] < m_up[arc]){
+            m_up[arc] = weights[e];
+            m_upEdge[arc] = e;
+        }
+    }
+    else if(weights[e] < m_down[arc]){
+        m_down[arc] = weights[e];
+        m_downEdge[arc] = e;
+    }
+}
+
+void ContractionHierarchy::relaxTriangle(int t)
+{
+    int lower = m_triangleLower[t];   //v - u
+    int middle = m_triangleMiddle[t]; //v - w
+    int upper = m_triangleUpper[t];   //u - w
+
+    double viaUp = m_down[lower] + m_up[middle]; //u -> v -> w
+    if(viaUp < m_up[upper]){
+        m_up[upper] = viaUp;
+        m_upEdge[upper] = NO_EDGE;
+        m_upTriangle[upper] = t;
+    }
+    double viaDown = m_down[middle] + m_up[lower]; //w -> v -> u
+    if(viaDown < m_down[upper]){
+        m_down[upper] = viaDown;
+        m_downEdge[upper] = NO_EDGE;
+        m_downTriangle[upper] = t;
+    }
+}
+
+  //one arc from scratch, relaxed in the same order customize() uses, so ties resolve the same way
+void ContractionHierarchy::customizeArc(int arc, const double* weights)
+{
+    m_up[arc] = INFINITE_WEIGHT;
+    m_down[arc] = INFINITE_WEIGHT;
+    m_upEdge[arc] = NO_EDGE;
+    m_downEdge[arc] = NO_EDGE;
+    m_upTriangle[arc] = -1;
+    m_downTriangle[arc] = -1;
+    for(int i = m_arcEdgeOffsets[arc]; i < m_arcEdgeOffsets[arc + 1]; i++){
+        relaxEdge(m_arcEdges[i], weights);
+    }
+    for(int i = m_relaxingOffsets[arc]; i < m_relaxingOffsets[arc + 1]; i++){
+        relaxTriangle(m_relaxing[i]);
+    }
+}
+
+void ContractionHierarchy::update(const double* weights, const vector<EdgeID>& changed)
+{
+    //arcs are redone by the rank of their lower node. Every triangle relaxing an arc has a lower node ranked
+    //below that, so its two lower arcs are final by the time the arc comes up, and an arc's weight changing
+    //can only affect arcs ranked above it
+    typedef pair<int, int> Pending; //(rank of the lower node, arc)
+    priority_queue<Pending, vector<Pending>, greater<Pending> > pending;
+    vector<bool> queued(m_targets.size(), false);
+    for(size_t i = 0; i < changed.size(); i++){
+        int arc = m_edgeArcs[changed[i]];
+        if(arc != -1 && !queued[arc]){
+            queued[arc] = true;
+            pending.push(Pending(m_rank[m_sources[arc]], arc));
+        }
+    }
+
+    while(!pending.empty()){
+        int arc = pending.top().second;
+        pending.pop();
+        double up = m_up[arc];
+        double down = m_down[arc];
+        customizeArc(arc, weights);
+        if(m_up[arc] == up && m_down[arc] == down){
+            continue; //nothing above it changes
+        }
+        for(int i = m_relaxedOffsets[arc]; i < m_relaxedOffsets[arc + 1]; i++){
+            int upper = m_triangleUpper[m_relaxed[i]];
+            if(!queued[upper]){
+                queued[upper] = true;
+                pending.push(Pending(m_rank[m_sources[upper]], upper));
+            }
+        }
+    }
+}
+
+template<typename Counter>
+bool ContractionHierarchy::route(NodeID start, NodeID end, vector<EdgeID>& path, Counter& counter) const
+{
+    if(start == end){
+        return true;
+    }
+
+    int numNodes = m_graph.numNodes();
+    SearchWorkspace& forward = threadWorkspace(0);
+    SearchWorkspace& backward = threadWorkspace(1);
+    forward.start(numNodes);
+    backward.start(numNodes);
+    forward.reach(start, 0, -1);
+    forward.heap.pushOrDecrease(start, 0);
+    backward.reach(end, 0, -1);
+    backward.heap.pushOrDecrease(end, 0);
+    counter.push(false);
+    counter.push(false);
+
+    double best = INFINITE_WEIGHT;
+    NodeID meet = NO_NODE;
+
+    for(;;){
+        double forwardKey = forward.heap.empty() ? INFINITE_WEIGHT : forward.heap.minKey();
+        double backwardKey = backward.heap.empty() ? INFINITE_WEIGHT : backward.heap.minKey();
+        if(min(forwardKey, backwardKey) >= best){ //neither side can still improve on the best meeting
+            break;
+        }
+
+        bool isForward = forwardKey <= backwardKey;
+        SearchWorkspace& ws = isForward ? forward : backward;
+        const SearchWorkspace& other = isForward ? backward : forward;
+        const vector<double>& weights = isForward ? m_up : m_down;
+
+        NodeID u = ws.heap.popMin();
+        ws.settle(u);
+        counter.pop();
+        counter.settle();
+        double du = ws.distance(u);
+        if(other.reached(u) && du + other.distance(u) < best){
+            best = du + other.distance(u);
+            meet = u;
+        }
+
+        for(int arc = m_arcOffsets[u]; arc < m_arcOffsets[u + 1]; arc++){
+            double d = du + weights[arc];
+            NodeID x = m_targets[arc];
+            if(d < INFINITE_WEIGHT && (!ws.reached(x) || d < ws.distance(x))){
+                ws.reach(x, d, arc);
+                counter.push(ws.heap.contains(x));
+                ws.heap.pushOrDecrease(x, d);
+            }
+        }
+    }
+
+    if(meet == NO_NODE){
+        return false;
+    }
+
+    //start -> meet climbs arcs upward; collect them from the meeting point back, then unpack in order
+    thread_local vector<int> arcs;
+    arcs.clear();
+    for(NodeID n = meet; n != start; n = m_sources[forward.parent(n)]){
+        arcs.push_back(forward.parent(n));
+    }
+    for(size_t i = arcs.size(); i-- > 0; ){
+        unpack(arcs[i], true, path);
+    }
+
+    //meet -> end descends the arcs the backward search climbed
+    for(NodeID n = meet; n != end; n = m_sources[backward.parent(n)]){
+        unpack(backward.parent(n), false, path);
+    }
+    return true;
+}
+
+template bool ContractionHierarchy::route(NodeID, NodeID, vector<EdgeID>&, NoCounting&) const;
+template bool ContractionHierarchy::route(NodeID, NodeID, vector<EdgeID>&, Counting&) const;
+
+void ContractionHierarchy::upwardSearch(NodeID from, bool up, vector<pair<NodeID, double> >& settled) const
+{
+    //exhaustive search of the upward arcs from one node: over up weights for distances from it, down weights for distances to it
+    SearchWorkspace& ws = threadWorkspace(up ? 0 : 1);
+    const vector<double>& weights = up ? m_up : m_down;
+    ws.start(m_graph.numNodes());
+    ws.reach(from, 0, -1);
+    ws.heap.pushOrDecrease(from, 0);
+    settled.clear();
+    while(!ws.heap.empty()){
+        NodeID u = ws.heap.popMin();
+        ws.settle(u);
+        double du = ws.distance(u);
+        settled.push_back(make_pair(u, du));
+        for(int arc = m_arcOffsets[u]; arc < m_arcOffsets[u + 1]; arc++){
+            double d = du + weights[arc];
+            NodeID x = m_targets[arc];
+            if(d < INFINITE_WEIGHT && (!ws.reached(x) || d < ws.distance(x))){
+                ws.reach(x, d, arc);
+                ws.heap.pushOrDecrease(x, d);
+            }
+        }
+    }
+}
+
+void ContractionHierarchy::distanceTable(const vector<NodeID>& sources, const vector<NodeID>& targets, vector<double>& table) const
+{
+    int numNodes = m_graph.numNodes();
+    int numTargets = targets.size();
+    table.assign(sources.size() * numTargets, INFINITE_WEIGHT);
+
+    //buckets: the (target, distance to target) entries left at each node, grouped by node with a counting sort
+    vector<pair<NodeID, double> > settled;
+    vector<NodeID> entryNode;
+    vector<pair<int, double> > entries;
+    for(int t = 0; t < numTargets; t++){
+        upwardSearch(targets[t], false, settled);
+        for(size_t i = 0; i < settled.size(); i++){
+            entryNode.push_back(settled[i].first);
+            entries.push_back(make_pair(t, settled[i].second));
+        }
+    }
+    vector<int> bucketStart(numNodes + 1, 0);
+    for(size_t i = 0; i < entryNode.size(); i++){
+        bucketStart[entryNode[i] + 1]++;
+    }
+    for(int n = 0; n < numNodes; n++){
+        bucketStart[n + 1] += bucketStart[n];
+    }
+    vector<pair<int, double> > buckets(entries.size());
+    vector<int> next(bucketStart.begin(), bucketStart.end() - 1);
+    for(size_t i = 0; i < entries.size(); i++){
+        buckets[next[entryNode[i]]++] = entries[i];
+    }
+
+    //every shortest path meets at its highest node, which both searches settle
+    for(size_t s = 0; s < sources.size(); s++){
+        double* row = &table[s * numTargets];
+        upwardSearch(sources[s], true, settled);
+        for(size_t i = 0; i < settled.size(); i++){
+            NodeID u = settled[i].first;
+            for(int b = bucketStart[u]; b < bucketStart[u + 1]; b++){
+                double d = settled[i].second + buckets[b].second;
+                if(d < row[buckets[b].first]){
+                    row[buckets[b].first] = d;
+                }
+            }
+        }
+    }
+}
+
+void ContractionHierarchy::unpack(int arc, bool up, vector<EdgeID>& path) const
+{
+    //explicit stack of (arc, direction) still to expand, next one on top
+    thread_local vector<pair<int, bool> > pending;
+    pending.clear();
+    pending.push_back(make_pair(arc, up));
+
+    while(!pending.empty()){
+        int a = pending.back().first;
+        bool isUp = pending.back().second;
+        pending.pop_back();
+
+        EdgeID e = isUp ? m_upEdge[a] : m_downEdge[a];
+        if(e != NO_EDGE){
+            path.push_back(e);
+            continue;
+        }
+
+        int t = isUp ? m_upTriangle[a] : m_downTriangle[a];
+        int lower = m_triangleLower[t];   //v - u
+        int middle = m_triangleMiddle[t]; //v - w
+        if(isUp){ //u -> v -> w
+            pending.push_back(make_pair(middle, true));
+            pending.push_back(make_pair(lower, false));
+        }
+        else{ //w -> v -> u
+            pending.push_back(make_pair(lower, true));
+            pending.push_back(make_pair(middle, false));
+        }
+    }
+}
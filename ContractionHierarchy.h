@@ -0,0 +1,100 @@
+#ifndef CONTRACTION_HIERARCHY_INCLUDED
+#define CONTRACTION_HIERARCHY_INCLUDED
+
+#include "provided.h"
+#include "StreetGraph.h"
+#include "Statistics.h"
+#include <vector>
+// ContractionHierarchy.h
+
+// Contraction hierarchy over a StreetGraph, built by StreetMap::buildHierarchy
+// and used by PointToPointRouters created with ROUTE_CONTRACTION_HIERARCHY.
+//
+// Nodes are contracted in minimum-degree order. Contracting a node connects
+// all of its remaining neighbors to each other, so the result is a set of
+// upward arcs (each from a node to a neighbor contracted later) that does not
+// depend on edge weights. customize() then computes the weight of every arc
+// in both directions from the street lengths: an arc starts with its
+// cheapest original segment and is relaxed through every lower triangle,
+// bottom-up. Because the shortcut structure is metric-independent, changed
+// segment weights only need another customization, not a new contraction,
+// and update() redoes just the arcs the changed segments reach: their own
+// arcs, then every arc a changed arc relaxes through a triangle, in the same
+// bottom-up order, stopping wherever a weight comes out as before.
+//
+// A query is a bidirectional Dijkstra that only climbs arcs: forward from the
+// start over upward weights, backward from the end over downward weights.
+// The shortest path meets at its highest node, and every arc on it unpacks
+// recursively into the original segments.
+class ContractionHierarchy
+{
+public:
+    ContractionHierarchy(const StreetGraph& graph);
+
+      // recomputes every arc weight from per-edge weights (kilometers)
+    void customize(const double* weights);
+
+      // the same result as customize(weights) when only the weights of the
+      // changed edges differ from the last customization
+    void update(const double* weights, const std::vector<EdgeID>& changed);
+
+      // appends the segments of a shortest start -> end path to path;
+      // false if end cannot be reached. counter sees the search's heap
+      // operations (see Statistics.h); instantiated for NoCounting and Counting.
+    template<typename Counter>
+    bool route(NodeID start, NodeID end, std::vector<EdgeID>& path, Counter& counter) const;
+
+      // fills table (row-major, sources x targets) with shortest distances in
+      // kilometers, infinity where there is no path. Bucket-based: one
+      // backward upward search per target leaves (target, distance) entries
+      // at every node it settles, then one forward upward search per source
+      // combines its distances with the buckets it finds.
+    void distanceTable(const std::vector<NodeID>& sources, const std::vector<NodeID>& targets, std::vector<double>& table) const;
+
+    int numArcs() const { return m_targets.size(); }
+    int numTriangles() const { return m_triangleLower.size(); }
+
+private:
+    const StreetGraph& m_graph;
+
+    std::vector<int> m_rank;            // contraction order, per node
+    std::vector<int> m_arcOffsets;      // upward arcs of node n: [m_arcOffsets[n], m_arcOffsets[n+1])
+    std::vector<NodeID> m_sources;      // per arc, the lower node
+    std::vector<NodeID> m_targets;      // per arc, the higher node
+
+      // per arc: cost lower -> higher ("up") and higher -> lower ("down"), and
+      // what achieves it: an original segment, or else a lower triangle
+    std::vector<double> m_up;
+    std::vector<double> m_down;
+    std::vector<EdgeID> m_upEdge;
+    std::vector<EdgeID> m_downEdge;
+    std::vector<int> m_upTriangle;
+    std::vector<int> m_downTriangle;
+
+      // lower triangles in contraction order: arcs (v,u), (v,w) and (u,w)
+      // where v is contracted before u and u before w
+    std::vector<int> m_triangleLower;   // arc v -> u
+    std::vector<int> m_triangleMiddle;  // arc v -> w
+    std::vector<int> m_triangleUpper;   // arc u -> w
+
+    std::vector<int> m_edgeArcs;        // per edge, the arc it belongs to (-1 for loops)
+
+      // for update(), per arc in CSR form: its edges, the triangles it is
+      // the upper arc of, and the triangles it is a lower or middle arc of
+    std::vector<int> m_arcEdgeOffsets;
+    std::vector<EdgeID> m_arcEdges;
+    std::vector<int> m_relaxingOffsets;
+    std::vector<int> m_relaxing;
+    std::vector<int> m_relaxedOffsets;
+    std::vector<int> m_relaxed;
+
+    void contract();
+    void indexArcs();
+    void relaxEdge(EdgeID e, const double* weights);
+    void relaxTriangle(int t);
+    void customizeArc(int arc, const double* weights);
+    void upwardSearch(NodeID from, bool up, std::vector<std::pair<NodeID, double> >& settled) const;
+    void unpack(int arc, bool up, std::vector<EdgeID>& path) const;
+};
+
+#endif // CONTRACTION_HIERARCHY_INCLUDED
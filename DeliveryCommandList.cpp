@@ -0,0 +1,104 @@
+#include "provided.h"
+#include "StreetGraph.h"
+#include <string>
+#include <vector>
+#include <cstdio>
+using namespace std;
+
+namespace {
+
+const char* const HEADING_NAMES[] = {
+    "east", "northeast", "north", "northwest", "west", "southwest", "south", "southeast", "error"
+};
+
+const char* const TURN_NAMES[] = { "left", "right" };
+
+}
+
+void DeliveryCommandList::clear(const StreetMap* sm)
+{
+    m_sm = sm;
+    m_commands.clear();
+    m_items.clear();
+}
+
+void DeliveryCommandList::appendDeliver(const string& item)
+{
+    CompactCommand deliver;
+    deliver.kind = CompactCommand::DELIVER;
+    deliver.direction = 0;
+    deliver.id = m_items.size();
+    deliver.miles = 0;
+    m_items.push_back(item);
+    m_commands.push_back(deliver);
+}
+
+const char* DeliveryCommandList::streetName(int nameId) const
+{
+    return m_sm->graph().name(nameId);
+}
+
+void DeliveryCommandList::appendDescription(const CompactCommand& command, string& text) const
+{
+    switch(command.kind){
+        case CompactCommand::TURN:
+            text += "Turn ";
+            text += TURN_NAMES[command.direction];
+            text += " on ";
+            text += streetName(command.id);
+            break;
+        case CompactCommand::PROCEED:{
+            char miles[32]; //%.2f rounds the way a fixed ostream with precision 2 does
+            int length = snprintf(miles, sizeof(miles), "%.2f", command.miles);
+            text += "Proceed ";
+            text += HEADING_NAMES[command.direction];
+            text += " on ";
+            text += streetName(command.id);
+            text += " for ";
+            text.append(miles, length);
+            text += " miles";
+            break;
+        }
+        case CompactCommand::DELIVER:
+            text += "DELIVER ";
+            text += m_items[command.id];
+            break;
+    }
+}
+
+string DeliveryCommandList::description(int i) const
+{
+    string text;
+    appendDescription(m_commands[i], text);
+    return text;
+}
+
+void DeliveryCommandList::render(string& text) const
+{
+    text.reserve(text.size() + 48 * m_commands.size()); //about one average line each, to grow at most a few times
+    for(size_t i = 0; i < m_commands.size(); i++){
+        appendDescription(m_commands[i], text);
+        text += '\n';
+    }
+}
+
+void DeliveryCommandList::toDeliveryCommands(vector<DeliveryCommand>& commands) const
+{
+    commands.reserve(commands.size() + m_commands.size());
+    for(size_t i = 0; i < m_commands.size(); i++){
+        const CompactCommand& c = m_commands[i];
+        DeliveryCommand command;
+        switch(c.kind){
+            case CompactCommand::PROCEED:
+                command.initAsProceedCommand(HEADING_NAMES[c.direction], streetName(c.id), c.miles);
+                break;
+            case CompactCommand::TURN:
+                command.initAsTurnCommand(TURN_NAMES[c.direction], streetName(c.id));
+                break;
+            case CompactCommand::DELIVER:
+                command.initAsDeliverCommand(m_items[c.id]);
+                break;
+        }
+        commands.push_back(command);
+    }
+}
@@ -1,7 +1,51 @@
 #include "provided.h"
+#include "Tour.h"
+#include "CrowDistance.h"
+#include "WorkerPool.h"
+#include "NeighborListSearch.h"
+#include "Statistics.h"
 #include <vector>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <chrono>
+#include <limits>
 using namespace std;
 
+namespace {
+
+const double EPSILON = 1e-9;            //smallest gain worth a move, so rounding can't make a search cycle
+const int LARGE_MANIFEST_STOPS = 200;   //beyond this, neighbor-list local search instead of annealing
+const double MILES_PER_KM = 1 / 1.609344;
+
+  //crow distances are symmetric; road distances usually aren't quite, because of one-way streets
+bool isSymmetric(const vector<double>& table, int size)
+{
+    for(int i = 0; i < size; i++){
+        for(int j = i + 1; j < size; j++){
+            if(fabs(table[i * size + j] - table[j * size + i]) > EPSILON){
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+  //tours still using a pair that costs unreachable have no road route, so their length is reported as infinite
+void reportUnreachable(double& oldDistance, double& newDistance, double unreachable)
+{
+    if(unreachable > 0){
+        if(oldDistance >= unreachable){
+            oldDistance = numeric_limits<double>::infinity();
+        }
+        if(newDistance >= unreachable){
+            newDistance = numeric_limits<double>::infinity();
+        }
+    }
+}
+
+}
+
 class DeliveryOptimizerImpl
 {
 public:
@@ -10,16 +54,30 @@ public:
     void optimizeDeliveryOrder(
         const GeoCoord& depot,
         vector<DeliveryRequest>& deliveries,
-        double& oldCrowDistance,
-        double& newCrowDistance) const;
+        const DistanceMatrix* roadDistances,
+        double& oldDistance,
+        double& newDistance) const;
+    void setAnnealingOptions(const AnnealingOptions& options) { m_options = options; }
+    void setStatistics(Statistics* stats) { m_stats = stats != nullptr ? stats->m_impl : nullptr; }
 private:
     double acceptanceProbability(double energy, double newEnergy, double temp) const;
+    //chains, like searches, take NoCounting or Counting (see Statistics.h)
+    template<typename Counter>
+    void annealChains(const vector<double>& table, int size, bool symmetric, const vector<int>& start, vector<int>& best, double& bestDistance) const;
+    template<typename Counter>
+    void anneal(const vector<double>& table, int size, bool symmetric, const vector<int>& start, int chain, vector<int>& best, double& bestDistance, Counter& counter) const;
+    template<typename Counter>
+    void annealStep(Tour& tour, bool symmetric, mt19937& generator, double temperature, Counter& counter) const;
+    void descend(Tour& tour, bool symmetric) const;
     const StreetMap* m_sm;
+    AnnealingOptions m_options;
+    StatisticsImpl* m_stats;
 };
 
 DeliveryOptimizerImpl::DeliveryOptimizerImpl(const StreetMap* sm)
 {
     m_sm = sm;
+    m_stats = nullptr;
 }
 
 DeliveryOptimizerImpl::~DeliveryOptimizerImpl()
@@ -35,77 +93,264 @@ double DeliveryOptimizerImpl::acceptanceProbability(double energy, double newEne
     
 }
 
+  //One annealing chain from start: random moves under a geometric cooling schedule from the start to the end
+  //temperature, then local search from the best tour seen. Every chain draws from its own generator, seeded
+  //from the options' seed and the chain number, so its result doesn't depend on which thread runs it.
+template<typename Counter>
+void DeliveryOptimizerImpl::anneal(const vector<double>& table, int size, bool symmetric, const vector<int>& start, int chain, vector<int>& best, double& bestDistance, Counter& counter) const{
+    typedef chrono::steady_clock Clock;
+    Clock::time_point began = Clock::now();
+    
+    seed_seq seeds {m_options.seed, (unsigned int)chain};
+    mt19937 generator (seeds);
+    Tour tour (table, size, start);
+    int n = tour.numStops();
+    best = start;
+    bestDistance = tour.length();
+    
+    long long iterations = m_options.iterations;
+    if(iterations <= 0){
+        iterations = min(2000LL * n, 1000000LL);
+    }
+    double startTemperature = m_options.startTemperature;
+    if(startTemperature <= 0){
+        startTemperature = 0.3 * tour.length() / (n + 1); //worsening by a third of an average leg is often accepted at first
+    }
+    double endTemperature = m_options.endTemperature > 0 ? m_options.endTemperature : startTemperature / 1000;
+    double cooling = pow(endTemperature / startTemperature, 1.0 / iterations);
+    double temperature = startTemperature;
+    
+    for(long long k = 0; k < iterations && n > 1; k++){
+        if(m_options.timeLimit > 0 && k % 1024 == 0 && chrono::duration<double>(Clock::now() - began).count() > m_options.timeLimit){
+            break;
+        }
+        annealStep(tour, symmetric, generator, temperature, counter);
+        counter.iterate();
+        
+        //if the current solution is better than the best solution, store it as the best solution
+        if(tour.length() < bestDistance - EPSILON){
+            bestDistance = tour.length();
+            best = tour.stops();
+        }
+        temperature *= cooling;
+    }
+    
+    //finish at the nearest local optimum of the best tour found
+    Tour finish (table, size, best);
+    descend(finish, symmetric);
+    best = finish.stops();
+    bestDistance = finish.measure();
+}
+
+  //one random swap, 2-opt or Or-opt move, kept if it shortens the tour and otherwise with the usual annealing probability
+template<typename Counter>
+void DeliveryOptimizerImpl::annealStep(Tour& tour, bool symmetric, mt19937& generator, double temperature, Counter& counter) const{
+    int n = tour.numStops();
+    uniform_real_distribution<double> unit (0, 1);
+    int kind = generator() % (symmetric ? 3 : 2);
+    
+    if(kind == 0){ //swap two stops
+        int i = 1 + generator() % n;
+        int j = 1 + generator() % n;
+        if(i == j){
+            return;
+        }
+        if(i > j){
+            swap(i, j);
+        }
+        if(unit(generator) < acceptanceProbability(0, tour.swapDelta(i, j), temperature)){
+            tour.applySwap(i, j);
+            counter.accept();
+        }
+    }
+    else if(kind == 1){ //move up to 3 consecutive stops elsewhere
+        int len = 1 + generator() % min(3, n - 1);
+        int i = 1 + generator() % (n - len + 1);
+        int j = generator() % (n - len); //any of the n + 1 gaps except the len + 1 next to or inside the segment
+        if(j >= i - 1){
+            j += len + 1;
+        }
+        if(unit(generator) < acceptanceProbability(0, tour.moveDelta(i, len, j), temperature)){
+            tour.applyMove(i, len, j);
+            counter.accept();
+        }
+    }
+    else{ //reverse a stretch of the tour
+        int i = 1 + generator() % n;
+        int j = 1 + generator() % n;
+        if(i == j){
+            return;
+        }
+        if(i > j){
+            swap(i, j);
+        }
+        if(unit(generator) < acceptanceProbability(0, tour.reverseDelta(i, j), temperature)){
+            tour.applyReverse(i, j);
+            counter.accept();
+        }
+    }
+}
+
+  //first-improvement local search: apply any shortening move until none is left
+void DeliveryOptimizerImpl::descend(Tour& tour, bool symmetric) const{
+    int n = tour.numStops();
+    bool improved = true;
+    while(improved){
+        improved = false;
+        if(symmetric){
+            for(int i = 1; i < n; i++){
+                for(int j = i + 1; j <= n; j++){
+                    if(tour.reverseDelta(i, j) < -EPSILON){
+                        tour.applyReverse(i, j);
+                        improved = true;
+                    }
+                }
+            }
+        }
+        for(int len = 1; len <= min(3, n - 1); len++){
+            for(int i = 1; i + len - 1 <= n; i++){
+                for(int j = 0; j <= n; j++){
+                    if(j >= i - 1 && j <= i + len - 1){
+                        continue;
+                    }
+                    if(tour.moveDelta(i, len, j) < -EPSILON){
+                        tour.applyMove(i, len, j);
+                        improved = true;
+                    }
+                }
+            }
+        }
+        for(int i = 1; i < n; i++){
+            for(int j = i + 1; j <= n; j++){
+                if(tour.swapDelta(i, j) < -EPSILON){
+                    tour.applySwap(i, j);
+                    improved = true;
+                }
+            }
+        }
+    }
+}
+
 void DeliveryOptimizerImpl::optimizeDeliveryOrder(
     const GeoCoord& depot,
     vector<DeliveryRequest>& deliveries,
-    double& oldCrowDistance,
-    double& newCrowDistance) const
+    const DistanceMatrix* roadDistances,
+    double& oldDistance,
+    double& newDistance) const
 {
-    oldCrowDistance = 0;
-    newCrowDistance = 0;
-    
-    oldCrowDistance += distanceEarthMiles(depot, deliveries[0].location);
-    for(int i = 0; i < deliveries.size()-1; i++){
-        oldCrowDistance += distanceEarthMiles(deliveries[i].location, deliveries[i+1].location);
+    ScopedLatency timer (m_stats, STAT_OPTIMIZE_TIME);
+    oldDistance = 0;
+    newDistance = 0;
+    if(deliveries.empty()){
+        return;
     }
-    oldCrowDistance += distanceEarthMiles(depot, deliveries[deliveries.size()-1].location);
     
-    int distance = oldCrowDistance;
-    double temperature = 10000;
-    double coolingFactor = 0.3;
-    vector<DeliveryRequest> currentSolution (deliveries);
-    vector<DeliveryRequest> bestSolution (deliveries);
-    double bestDistance = oldCrowDistance;
+    //0 is the depot, i + 1 is deliveries[i]
+    int size = deliveries.size() + 1;
+    bool useRoads = roadDistances != nullptr && roadDistances->size() == size;
+    vector<int> order (deliveries.size());
+    for(size_t i = 0; i < order.size(); i++){
+        order[i] = i + 1;
+    }
+    GeoPoints points;
+    if(!useRoads){
+        points.reserve(size);
+        points.add(depot);
+        for(size_t i = 0; i < deliveries.size(); i++){
+            points.add(deliveries[i].location);
+        }
+    }
     
-    while(temperature > 1){
-        vector<DeliveryRequest> newDeliveries (currentSolution);
-        
-        int randPos1 = rand() % newDeliveries.size(); //creating 2 random indexes
-        int randPos2 = rand() % newDeliveries.size();
-        
-        //swapping the elements at the 2 indexes
-        DeliveryRequest temp = newDeliveries[randPos1];
-        newDeliveries[randPos1] = newDeliveries[randPos2];
-        newDeliveries[randPos2] = temp;
-        
-        //calculating the distance with the new order
-        double newDistance = 0;
-        newDistance += distanceEarthMiles(depot, newDeliveries[0].location);
-        for(int i = 0; i < newDeliveries.size()-1; i++){
-            newDistance += distanceEarthMiles(newDeliveries[i].location, newDeliveries[i+1].location);
+    //distances between every pair of points
+    vector<double> table;
+    double unreachable = 0; //what a pair without a road route costs, if there is one
+    if(useRoads){
+        table.resize(size * size);
+        double longest = 0;
+        bool missing = false;
+        for(int i = 0; i < size; i++){
+            for(int j = 0; j < size; j++){
+                table[i * size + j] = roadDistances->distance(i, j);
+                if(roadDistances->reachable(i, j)){
+                    longest = max(longest, table[i * size + j]);
+                }
+                else{
+                    missing = true;
+                }
+            }
         }
-        newDistance += distanceEarthMiles(depot, newDeliveries[newDeliveries.size()-1].location);
-        
-       //random probability
-        double randProb = (rand() % 100)/ 100;
-        
-        //accept the solution if it is shorter, or longer with a certain probability according to the acceptanceProbability function
-        if(acceptanceProbability(newDistance, distance, temperature) > randProb){
-            currentSolution = newDeliveries;
+        //infinite entries would make every length and delta inf or NaN; a cost above any tour of reachable legs
+        //keeps the search finite and still leaves such pairs out whenever some order can
+        if(missing){
+            unreachable = size * (longest + 1);
+            for(int i = 0; i < size; i++){
+                for(int j = 0; j < size; j++){
+                    if(!roadDistances->reachable(i, j)){
+                        table[i * size + j] = unreachable;
+                    }
+                }
+            }
         }
-        
-        //calc current solution distance and compare with best
-        double currentDistance = 0;
-        currentDistance += distanceEarthMiles(depot, currentSolution[0].location);
-        for(int i = 0; i < currentSolution.size()-1; i++){
-            currentDistance += distanceEarthMiles(currentSolution[i].location, currentSolution[i+1].location);
+    }
+    else if(deliveries.size() <= LARGE_MANIFEST_STOPS){
+        table.resize(size * size);
+        crowDistanceMatrixKM(points, table.data());
+        for(size_t i = 0; i < table.size(); i++){
+            table[i] *= MILES_PER_KM;
         }
-        currentDistance += distanceEarthMiles(depot, currentSolution[currentSolution.size()-1].location);
-        
-        //if the new solution is better than the best solution, store it as the best solution
-        if(currentDistance < bestDistance){
-            bestDistance = currentDistance;
-            bestSolution = currentSolution;
+    }
+    
+    if(deliveries.size() > LARGE_MANIFEST_STOPS){ //crow distances are computed as needed rather than tabled
+        NeighborListSearch search = useRoads ? NeighborListSearch(table, size, isSymmetric(table, size)) : NeighborListSearch(points, MILES_PER_KM);
+        oldDistance = search.tourLength(order);
+        newDistance = search.improve(order);
+        reportUnreachable(oldDistance, newDistance, unreachable);
+        vector<DeliveryRequest> original (deliveries);
+        for(size_t i = 0; i < deliveries.size(); i++){
+            deliveries[i] = original[order[i] - 1];
         }
-        
-        temperature *= 1-coolingFactor; //decrease the temperature
+        return;
     }
     
-    for(int i = 0; i < deliveries.size(); i++){ //copy the bestSolution into deliveries
-        deliveries[i] = bestSolution[i];
+    bool symmetric = isSymmetric(table, size);
+    oldDistance = Tour(table, size, order).measure();
+    
+    vector<int> bestSolution;
+    if(m_stats == nullptr){
+        annealChains<NoCounting>(table, size, symmetric, order, bestSolution, newDistance);
+    }
+    else{
+        annealChains<Counting>(table, size, symmetric, order, bestSolution, newDistance);
     }
+    reportUnreachable(oldDistance, newDistance, unreachable);
+    
+    vector<DeliveryRequest> original (deliveries);
+    for(size_t i = 0; i < deliveries.size(); i++){ //copy the bestSolution into deliveries
+        deliveries[i] = original[bestSolution[i] - 1];
+    }
+}
+
+  //independent chains in parallel; the shortest tour wins, the lowest chain on ties
+template<typename Counter>
+void DeliveryOptimizerImpl::annealChains(const vector<double>& table, int size, bool symmetric, const vector<int>& start, vector<int>& best, double& bestDistance) const{
+    int chains = m_options.chains > 0 ? m_options.chains : sharedWorkerPool().numThreads();
+    vector<vector<int> > results (chains);
+    vector<double> distances (chains);
+    vector<Counter> counters (chains);
+    sharedWorkerPool().parallelFor(chains, [&](int chain){
+        anneal(table, size, symmetric, start, chain, results[chain], distances[chain], counters[chain]);
+    });
+    int winner = min_element(distances.begin(), distances.end()) - distances.begin();
+    best.swap(results[winner]);
+    bestDistance = distances[winner];
     
-    newCrowDistance = bestDistance; //update the distance of the new ordering
+    Counter total;
+    for(int chain = 0; chain < chains; chain++){
+        total.add(counters[chain]);
+    }
+    if(m_stats != nullptr){
+        m_stats->add(total);
+    }
 }
 
 
@@ -130,5 +375,25 @@ void DeliveryOptimizer::optimizeDeliveryOrder(
         double& oldCrowDistance,
         double& newCrowDistance) const
 {
-    return m_impl->optimizeDeliveryOrder(depot, deliveries, oldCrowDistance, newCrowDistance);
+    return m_impl->optimizeDeliveryOrder(depot, deliveries, nullptr, oldCrowDistance, newCrowDistance);
+}
+
+void DeliveryOptimizer::optimizeDeliveryOrder(
+        const GeoCoord& depot,
+        vector<DeliveryRequest>& deliveries,
+        const DistanceMatrix& roadDistances,
+        double& oldDistance,
+        double& newDistance) const
+{
+    return m_impl->optimizeDeliveryOrder(depot, deliveries, &roadDistances, oldDistance, newDistance);
+}
+
+void DeliveryOptimizer::setAnnealingOptions(const AnnealingOptions& options)
+{
+    m_impl->setAnnealingOptions(options);
+}
+
+void DeliveryOptimizer::setStatistics(Statistics* stats)
+{
+    m_impl->setStatistics(stats);
 }
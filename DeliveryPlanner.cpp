@@ -1,75 +1,176 @@
 #include "provided.h"
 #include <vector>
 #include "ExpandableHashMap.h"
+#include "WorkerPool.h"
+#include "FleetPartition.h"
+#include "SpatialIndex.h"
+#include "Statistics.h"
+#include "StreetGraph.h"
+#include <chrono>
+#include <cmath>
 using namespace std;
 
+namespace {
+
+  //angleOfLine of edge e's StreetSegment, from the same coordinates but without building it
+double edgeAngle(const StreetGraph& graph, EdgeID e)
+{
+    double angle = atan2(graph.latitude(graph.target(e)) - graph.latitude(graph.source(e)),
+                         graph.longitude(graph.target(e)) - graph.longitude(graph.source(e)));
+    double result = rad2deg(angle);
+    if(result < 0){
+        result += 360;
+    }
+    return result;
+}
+
+  //angleBetween2Lines of two edges' StreetSegments, likewise
+double turnAngle(const StreetGraph& graph, EdgeID from, EdgeID to)
+{
+    double angle1 = atan2(graph.latitude(graph.target(from)) - graph.latitude(graph.source(from)),
+                          graph.longitude(graph.target(from)) - graph.longitude(graph.source(from)));
+    double angle2 = atan2(graph.latitude(graph.target(to)) - graph.latitude(graph.source(to)),
+                          graph.longitude(graph.target(to)) - graph.longitude(graph.source(to)));
+    double result = rad2deg(angle2 - angle1);
+    if(result < 0){
+        result += 360;
+    }
+    return result;
+}
+
+  //the sector of a line's angle, as named in Heading
+Heading headingOf(double angle){
+    if(0 <= angle && angle < 22.5){
+        return HEADING_EAST;
+    }else if(22.5 <= angle && angle < 67.5){
+        return HEADING_NORTHEAST;
+    }else if(67.5 <= angle && angle < 112.5){
+        return HEADING_NORTH;
+    }else if(112.5 <= angle && angle < 157.5){
+        return HEADING_NORTHWEST;
+    }else if(157.5 <= angle && angle < 202.5){
+        return HEADING_WEST;
+    }else if(202.5 <= angle && angle < 247.5){
+        return HEADING_SOUTHWEST;
+    }else if(247.5 <= angle && angle < 292.5){
+        return HEADING_SOUTH;
+    }else if(292.5 <= angle && angle <337.5){
+        return HEADING_EAST;
+    }
+    else if(angle >= 337.5){
+        return HEADING_SOUTHEAST;
+    }else{
+        return HEADING_UNKNOWN;
+    }
+}
+
+  //a proceed command along edge e, for miles
+CompactCommand proceed(const StreetGraph& graph, EdgeID e, double miles)
+{
+    CompactCommand d;
+    d.kind = CompactCommand::PROCEED;
+    d.direction = headingOf(edgeAngle(graph, e));
+    d.id = graph.nameId(e);
+    d.miles = miles;
+    return d;
+}
+
+}
+
 class DeliveryPlannerImpl
 {
 public:
-    DeliveryPlannerImpl(const StreetMap* sm);
+    DeliveryPlannerImpl(const StreetMap* sm, RouteAlgorithm algorithm);
     ~DeliveryPlannerImpl();
     DeliveryResult generateDeliveryPlan(
         const GeoCoord& depot,
         const vector<DeliveryRequest>& deliveries,
         vector<DeliveryCommand>& commands,
         double& totalDistanceTravelled) const;
+    DeliveryResult generateCompactDeliveryPlan(
+        const GeoCoord& depot,
+        const vector<DeliveryRequest>& deliveries,
+        DeliveryCommandList& commands,
+        double& totalDistanceTravelled) const;
+    DeliveryResult generateTimedDeliveryPlan(
+        const GeoCoord& depot,
+        const vector<DeliveryRequest>& deliveries,
+        double departure,
+        vector<DeliveryCommand>& commands,
+        double& totalDistanceTravelled,
+        vector<double>& arrivals) const;
+    DeliveryBatchStats generateDeliveryPlans(
+        const vector<DeliveryJob>& jobs,
+        vector<DeliveryJobResult>& results) const;
+    DeliveryResult generateFleetPlan(
+        const GeoCoord& depot,
+        const vector<DeliveryRequest>& deliveries,
+        int numVehicles,
+        vector<VehiclePlan>& plans,
+        double& totalDistanceTravelled,
+        const vector<int>& capacities) const;
+    void setRouteCache(RouteCache* cache) { m_router.setRouteCache(cache); }
+    void setAnnealingOptions(const AnnealingOptions& options) { m_optimizer.setAnnealingOptions(options); }
+    void setSnapDistance(double miles);
+    void setStatistics(Statistics* stats);
 private:
     const StreetMap* m_sm;
-    string getDir(const StreetSegment s) const;
-    string getTurnDir(double angle) const;
+    double m_snapMiles;
+    StatisticsImpl* m_stats;
+    PointToPointRouter m_router; //its const methods are safe to call from several threads at once
+    DeliveryOptimizer m_optimizer;
+    DeliveryResult planDeliveries(
+        const GeoCoord& depot,
+        vector<DeliveryRequest>& deliveries,
+        DeliveryCommandList& commands,
+        double& totalDistanceTravelled,
+        double departure = 0,
+        vector<double>* arrivals = nullptr) const;
+    DeliveryResult planDeliveries(
+        const GeoCoord& depot,
+        vector<DeliveryRequest>& deliveries,
+        vector<DeliveryCommand>& commands,
+        double& totalDistanceTravelled,
+        double departure = 0,
+        vector<double>* arrivals = nullptr) const;
+    bool onMap(const GeoCoord& gc) const;
     
     
 };
 
-DeliveryPlannerImpl::DeliveryPlannerImpl(const StreetMap* sm)
+DeliveryPlannerImpl::DeliveryPlannerImpl(const StreetMap* sm, RouteAlgorithm algorithm)
+ : m_router(sm, algorithm), m_optimizer(sm)
 {
     m_sm = sm;
+    m_snapMiles = 0;
+    m_stats = nullptr;
 }
 
 DeliveryPlannerImpl::~DeliveryPlannerImpl()
 {
 }
 
-string DeliveryPlannerImpl::getDir(const StreetSegment s) const{
-    
-    double angle = angleOfLine(s);
-    
-    if(0 <= angle && angle < 22.5){
-        return "east";
-    }else if(22.5 <= angle && angle < 67.5){
-        return "northeast";
-    }else if(67.5 <= angle && angle < 112.5){
-        return "north";
-    }else if(112.5 <= angle && angle < 157.5){
-        return "northwest";
-    }else if(157.5 <= angle && angle < 202.5){
-        return "west";
-    }else if(202.5 <= angle && angle < 247.5){
-        return "southwest";
-    }else if(247.5 <= angle && angle < 292.5){
-        return "south";
-    }else if(292.5 <= angle && angle <337.5){
-        return "east";
-    }
-    else if(angle >= 337.5){
-        return "southeast";
-    }else{
-        return "error";
-    }
-    
+void DeliveryPlannerImpl::setSnapDistance(double miles)
+{
+    m_snapMiles = miles;
+    m_router.setSnapDistance(miles);
 }
 
-string DeliveryPlannerImpl::getTurnDir(double angle) const{
-    if(angle < 1 || angle > 359){
-        return "straight";
-    }
-    else if(angle >= 1 && angle < 180){
-        return "left";
-    }
-    else{
-        return "right";
-    }
+void DeliveryPlannerImpl::setStatistics(Statistics* stats)
+{
+    m_stats = stats != nullptr ? stats->m_impl : nullptr;
+    m_router.setStatistics(stats);
+    m_optimizer.setStatistics(stats);
+}
 
+  //a vertex, or near enough to one to be snapped to it
+bool DeliveryPlannerImpl::onMap(const GeoCoord& gc) const
+{
+    if(m_sm->contains(gc)){
+        return true;
+    }
+    const double kmPerMile = 1.609344;
+    return m_snapMiles > 0 && m_sm->spatialIndex().nearestNode(gc.latitude, gc.longitude, m_snapMiles * kmPerMile) != NO_NODE;
 }
 
 DeliveryResult DeliveryPlannerImpl::generateDeliveryPlan(
@@ -78,118 +179,228 @@ DeliveryResult DeliveryPlannerImpl::generateDeliveryPlan(
     vector<DeliveryCommand>& commands,
     double& totalDistanceTravelled) const
 {
-    DeliveryOptimizer d (m_sm);
     vector<DeliveryRequest> newDeliveries (deliveries);
+    return planDeliveries(depot, newDeliveries, commands, totalDistanceTravelled);
+}
+
+DeliveryResult DeliveryPlannerImpl::generateCompactDeliveryPlan(
+    const GeoCoord& depot,
+    const vector<DeliveryRequest>& deliveries,
+    DeliveryCommandList& commands,
+    double& totalDistanceTravelled) const
+{
+    vector<DeliveryRequest> newDeliveries (deliveries);
+    return planDeliveries(depot, newDeliveries, commands, totalDistanceTravelled);
+}
+
+DeliveryResult DeliveryPlannerImpl::generateTimedDeliveryPlan(
+    const GeoCoord& depot,
+    const vector<DeliveryRequest>& deliveries,
+    double departure,
+    vector<DeliveryCommand>& commands,
+    double& totalDistanceTravelled,
+    vector<double>& arrivals) const
+{
+    vector<DeliveryRequest> newDeliveries (deliveries);
+    return planDeliveries(depot, newDeliveries, commands, totalDistanceTravelled, departure, &arrivals);
+}
+
+  //generateCompactDeliveryPlan, leaving the deliveries in the order they are made; with arrivals, legs are
+  //quickest routes chained from departure instead
+DeliveryResult DeliveryPlannerImpl::planDeliveries(
+    const GeoCoord& depot,
+    vector<DeliveryRequest>& newDeliveries,
+    DeliveryCommandList& commands,
+    double& totalDistanceTravelled,
+    double departure,
+    vector<double>* arrivals) const
+{
+    ScopedLatency timer (m_stats, STAT_PLAN_TIME);
+    commands.clear(m_sm);
+    totalDistanceTravelled = 0;
     double oldCrowDistance, newCrowDistance = 0;
-    d.optimizeDeliveryOrder(depot, newDeliveries, oldCrowDistance, newCrowDistance);
+    m_optimizer.optimizeDeliveryOrder(depot, newDeliveries, oldCrowDistance, newCrowDistance);
     
     
     //checking for invalid depot or delivery request location
-    vector<StreetSegment> segs;
-    if(!m_sm->getSegmentsThatStartWith(depot, segs))
+    if(!onMap(depot))
         return BAD_COORD;
-    for(int i = 0; i < deliveries.size(); i++){
-        if(!m_sm->getSegmentsThatStartWith(deliveries[i].location, segs)){
+    for(size_t i = 0; i < newDeliveries.size(); i++){
+        if(!onMap(newDeliveries[i].location)){
             return BAD_COORD;
         }
     }
     
-    vector<list<StreetSegment>> routes;
-    
-    GeoCoord start = depot;
-    GeoCoord end;
-
-    PointToPointRouter p (m_sm);
-    
-    //depot to 1st point
-    list<StreetSegment> initRoute;
-    double initDistance = 0;
-    p.generatePointToPointRoute(depot, newDeliveries[0].location, initRoute, initDistance);
-    routes.push_back(initRoute);
-    
-    for(int i = 0; i < newDeliveries.size()-1; i++){
-        GeoCoord start = newDeliveries[i].location;
-        GeoCoord end = newDeliveries[i+1].location;
-        
-        list<StreetSegment> route;
-        double totalDist = 0;
-        if(p.generatePointToPointRoute(start, end, route, totalDist) == NO_ROUTE){
-            return NO_ROUTE;
+    //legs: depot to 1st point, each point to the next, last point back to the depot.
+    //they are independent, so they are routed in parallel and then read back in order
+    int numLegs = newDeliveries.size() + 1;
+    vector<vector<EdgeID>> paths (numLegs);
+    vector<DeliveryResult> results (numLegs);
+    auto legStart = [&](int leg) -> const GeoCoord& { return leg == 0 ? depot : newDeliveries[leg-1].location; };
+    auto legEnd = [&](int leg) -> const GeoCoord& { return leg == numLegs-1 ? depot : newDeliveries[leg].location; };
+    if(arrivals == nullptr){
+        sharedWorkerPool().parallelFor(numLegs, [&](int leg){
+            double legDistance = 0;
+            results[leg] = m_router.generatePointToPointPath(legStart(leg), legEnd(leg), paths[leg], legDistance);
+        });
+    }
+    else{ //unless each leg leaves when the one before arrives, so they can only be routed in turn
+        arrivals->assign(numLegs, departure);
+        double time = departure;
+        for(int leg = 0; leg < numLegs; leg++){
+            double legDistance = 0;
+            results[leg] = m_router.generateTimedPath(legStart(leg), legEnd(leg), time, paths[leg], legDistance, time);
+            if(results[leg] != DELIVERY_SUCCESS){
+                return results[leg];
+            }
+            (*arrivals)[leg] = time;
         }
-        routes.push_back(route);
     }
     
-//    end point to depot
-    list<StreetSegment> finalRoute;
-    double finalDistance = 0;
-    p.generatePointToPointRoute(newDeliveries[newDeliveries.size()-1].location, depot, finalRoute, finalDistance);
-    routes.push_back(finalRoute);
-    
-    
+    for(int leg = 0; leg < numLegs; leg++){ //the legs to and from the depot too, as the timed path checks
+        if(results[leg] != DELIVERY_SUCCESS){
+            return results[leg];
+        }
+    }
     
-    //planning starting here
-    for(int j = 0; j < routes.size(); j++){ //for each route
-        if(routes[j].size() != 0){ //case of duplicates
-            string currentName = (*(routes[j].begin())).name;
-            DeliveryCommand d;
-            string dir = getDir((*routes[j].begin()));
-            
-            double dist = 0;
-            
-
-
-            d.initAsProceedCommand(dir, currentName, dist);
-
-            for(auto it = routes[j].begin(); it != routes[j].end(); it++){ //for each segment in the route
-
-                
-                
-                if(currentName != it->name){ //if new street reached
-            
-                    commands.push_back(d);
-
-                    //make and push turn command
-                    DeliveryCommand turn;
-                    list<StreetSegment>::iterator prevIt = --it;
-                    it++;
-                    double turnAngle = angleBetween2Lines((*(prevIt)), (*it));
+    //planning starting here: a proceed command for every stretch along one street, a turn command between
+    //them unless it is straight on, and a deliver command at the end of every leg but the last
+    const StreetGraph& graph = m_sm->graph();
+    for(int j = 0; j < numLegs; j++){ //for each route
+        const vector<EdgeID>& path = paths[j];
+        if(!path.empty()){ //case of duplicates
+            CompactCommand d = proceed(graph, path[0], 0);
+            for(size_t k = 0; k < path.size(); k++){ //for each segment in the route
+                double miles = graph.lengthMiles(path[k]);
+                if(graph.nameId(path[k]) != d.id){ //if new street reached
+                    commands.append(d);
                     
-                    if(getTurnDir(turnAngle) != "straight"){
-                        
-                        turn.initAsTurnCommand(getTurnDir(turnAngle), it->name);
-                        commands.push_back(turn);
+                    double angle = turnAngle(graph, path[k-1], path[k]);
+                    if(!(angle < 1 || angle > 359)){ //not straight on
+                        CompactCommand turn;
+                        turn.kind = CompactCommand::TURN;
+                        turn.direction = angle >= 1 && angle < 180 ? TURN_LEFT : TURN_RIGHT;
+                        turn.id = graph.nameId(path[k]);
+                        turn.miles = 0;
+                        commands.append(turn);
                     }
-
-                    //make new proceed command
-                    double newDist = 0;
                     
-                    d.initAsProceedCommand(getDir(*it), it->name, newDist);
-                    d.increaseDistance(distanceEarthMiles(it->start, it->end));
-                    totalDistanceTravelled += distanceEarthMiles(it->start, it->end);
-                    currentName = it->name;
-
+                    d = proceed(graph, path[k], miles);
                 }
                 else{
-                    //increase the distance of the proceed command
-                    d.increaseDistance(distanceEarthMiles(it->start, it->end));
-                    totalDistanceTravelled += distanceEarthMiles(it->start, it->end);
-
+                    d.miles += miles; //increase the distance of the proceed command
                 }
+                totalDistanceTravelled += miles;
             }
-            
-            commands.push_back(d);
+            commands.append(d);
+        }
+        
+        if(j != numLegs-1){ //end of the route, create a delivery command
+            commands.appendDeliver(newDeliveries[j].item);
         }
+    }
+    
+    return DELIVERY_SUCCESS;
+}
 
-        if(j != routes.size()-1){ //end of the route, create a delivery command
-            DeliveryCommand delivery;
-            delivery.initAsDeliverCommand(newDeliveries[j].item);
-            commands.push_back(delivery);
+  //the same plan, appended to commands as DeliveryCommands
+DeliveryResult DeliveryPlannerImpl::planDeliveries(
+    const GeoCoord& depot,
+    vector<DeliveryRequest>& newDeliveries,
+    vector<DeliveryCommand>& commands,
+    double& totalDistanceTravelled,
+    double departure,
+    vector<double>* arrivals) const
+{
+    DeliveryCommandList compact;
+    DeliveryResult result = planDeliveries(depot, newDeliveries, compact, totalDistanceTravelled, departure, arrivals);
+    compact.toDeliveryCommands(commands);
+    return result;
+}
+
+DeliveryBatchStats DeliveryPlannerImpl::generateDeliveryPlans(
+    const vector<DeliveryJob>& jobs,
+    vector<DeliveryJobResult>& results) const
+{
+    typedef chrono::steady_clock Clock;
+    
+    results.assign(jobs.size(), DeliveryJobResult());
+    Clock::time_point batchStart = Clock::now();
+    
+    //one job per index; each job's legs are spread over the same pool as well
+    sharedWorkerPool().parallelFor(jobs.size(), [&](int i){
+        Clock::time_point jobStart = Clock::now();
+        DeliveryJobResult& r = results[i];
+        r.result = generateDeliveryPlan(jobs[i].depot, jobs[i].deliveries, r.commands, r.totalDistanceTravelled);
+        r.seconds = chrono::duration<double>(Clock::now() - jobStart).count();
+    });
+    
+    DeliveryBatchStats stats;
+    stats.numJobs = jobs.size();
+    stats.seconds = chrono::duration<double>(Clock::now() - batchStart).count();
+    stats.jobsPerSecond = stats.seconds > 0 ? stats.numJobs / stats.seconds : 0;
+    stats.meanJobSeconds = 0;
+    stats.maxJobSeconds = 0;
+    for(size_t i = 0; i < results.size(); i++){
+        stats.meanJobSeconds += results[i].seconds;
+        stats.maxJobSeconds = max(stats.maxJobSeconds, results[i].seconds);
+    }
+    if(!results.empty()){
+        stats.meanJobSeconds /= results.size();
+    }
+    return stats;
+}
 
+DeliveryResult DeliveryPlannerImpl::generateFleetPlan(
+    const GeoCoord& depot,
+    const vector<DeliveryRequest>& deliveries,
+    int numVehicles,
+    vector<VehiclePlan>& plans,
+    double& totalDistanceTravelled,
+    const vector<int>& capacities) const
+{
+    plans.assign(max(numVehicles, 0), VehiclePlan());
+    totalDistanceTravelled = 0;
+    if(!onMap(depot))
+        return BAD_COORD;
+    for(size_t i = 0; i < deliveries.size(); i++){
+        if(!onMap(deliveries[i].location)){
+            return BAD_COORD;
         }
-        
     }
-         
-    return DELIVERY_SUCCESS;
+    
+    //0 is the depot, i + 1 is deliveries[i]
+    GeoPoints points;
+    points.reserve(deliveries.size() + 1);
+    points.add(depot);
+    for(size_t i = 0; i < deliveries.size(); i++){
+        points.add(deliveries[i].location);
+    }
+    vector<vector<int> > routes;
+    const double milesPerKm = 1 / 1.609344;
+    if(!FleetPartition(points, milesPerKm).partition(numVehicles, capacities, routes)){
+        return NO_ROUTE;
+    }
+    
+    //vehicles are planned in parallel, and each one's legs on the same pool
+    sharedWorkerPool().parallelFor(plans.size(), [&](int v){
+        VehiclePlan& plan = plans[v];
+        for(size_t i = 0; i < routes[v].size(); i++){
+            plan.deliveries.push_back(deliveries[routes[v][i] - 1]);
+        }
+        if(!plan.deliveries.empty()){
+            plan.result = planDeliveries(depot, plan.deliveries, plan.commands, plan.totalDistanceTravelled);
+        }
+    });
+    
+    DeliveryResult result = DELIVERY_SUCCESS;
+    for(size_t v = 0; v < plans.size(); v++){
+        totalDistanceTravelled += plans[v].totalDistanceTravelled;
+        if(result == DELIVERY_SUCCESS){
+            result = plans[v].result;
+        }
+    }
+    return result;
 }
 
 //******************** DeliveryPlanner functions ******************************
@@ -197,9 +408,9 @@ DeliveryResult DeliveryPlannerImpl::generateDeliveryPlan(
 // These functions simply delegate to DeliveryPlannerImpl's functions.
 // You probably don't want to change any of this code.
 
-DeliveryPlanner::DeliveryPlanner(const StreetMap* sm)
+DeliveryPlanner::DeliveryPlanner(const StreetMap* sm, RouteAlgorithm algorithm)
 {
-    m_impl = new DeliveryPlannerImpl(sm);
+    m_impl = new DeliveryPlannerImpl(sm, algorithm);
 }
 
 DeliveryPlanner::~DeliveryPlanner()
@@ -215,3 +426,61 @@ DeliveryResult DeliveryPlanner::generateDeliveryPlan(
 {
     return m_impl->generateDeliveryPlan(depot, deliveries, commands, totalDistanceTravelled);
 }
+
+DeliveryResult DeliveryPlanner::generateCompactDeliveryPlan(
+    const GeoCoord& depot,
+    const vector<DeliveryRequest>& deliveries,
+    DeliveryCommandList& commands,
+    double& totalDistanceTravelled) const
+{
+    return m_impl->generateCompactDeliveryPlan(depot, deliveries, commands, totalDistanceTravelled);
+}
+
+DeliveryBatchStats DeliveryPlanner::generateDeliveryPlans(
+    const vector<DeliveryJob>& jobs,
+    vector<DeliveryJobResult>& results) const
+{
+    return m_impl->generateDeliveryPlans(jobs, results);
+}
+
+DeliveryResult DeliveryPlanner::generateFleetPlan(
+    const GeoCoord& depot,
+    const vector<DeliveryRequest>& deliveries,
+    int numVehicles,
+    vector<VehiclePlan>& plans,
+    double& totalDistanceTravelled,
+    const vector<int>& capacities) const
+{
+    return m_impl->generateFleetPlan(depot, deliveries, numVehicles, plans, totalDistanceTravelled, capacities);
+}
+
+DeliveryResult DeliveryPlanner::generateTimedDeliveryPlan(
+    const GeoCoord& depot,
+    const vector<DeliveryRequest>& deliveries,
+    double departure,
+    vector<DeliveryCommand>& commands,
+    double& totalDistanceTravelled,
+    vector<double>& arrivals) const
+{
+    return m_impl->generateTimedDeliveryPlan(depot, deliveries, departure, commands, totalDistanceTravelled, arrivals);
+}
+
+void DeliveryPlanner::setRouteCache(RouteCache* cache)
+{
+    m_impl->setRouteCache(cache);
+}
+
+void DeliveryPlanner::setAnnealingOptions(const AnnealingOptions& options)
+{
+    m_impl->setAnnealingOptions(options);
+}
+
+void DeliveryPlanner::setSnapDistance(double miles)
+{
+    m_impl->setSnapDistance(miles);
+}
+
+void DeliveryPlanner::setStatistics(Statistics* stats)
+{
+    m_impl->setStatistics(stats);
+}
@@ -0,0 +1,136 @@
+#include "provided.h"
+#include "StreetGraph.h"
+#include "SearchWorkspace.h"
+#include "ContractionHierarchy.h"
+#include <vector>
+#include <limits>
+#include <algorithm>
+using namespace std;
+
+class DistanceMatrixImpl
+{
+public:
+    DistanceMatrixImpl(const StreetMap* sm);
+    ~DistanceMatrixImpl();
+    DeliveryResult compute(const vector<GeoCoord>& points);
+    int size() const { return m_size; }
+    double distance(int from, int to) const { return m_miles[from * m_size + to]; }
+private:
+    const StreetMap* m_sm;
+    int m_size;
+    vector<double> m_miles;     // row-major, m_size x m_size
+
+    void dijkstraTable(const vector<NodeID>& nodes, vector<double>& table) const;
+};
+
+DistanceMatrixImpl::DistanceMatrixImpl(const StreetMap* sm)
+{
+    m_sm = sm;
+    m_size = 0;
+}
+
+DistanceMatrixImpl::~DistanceMatrixImpl()
+{
+}
+
+DeliveryResult DistanceMatrixImpl::compute(const vector<GeoCoord>& points)
+{
+    const StreetGraph& graph = m_sm->graph();
+    vector<NodeID> nodes(points.size());
+    for(size_t i = 0; i < points.size(); i++){
+        if(!graph.findNode(points[i], nodes[i])){
+            return BAD_COORD;
+        }
+    }
+
+    vector<double> table;
+    const ContractionHierarchy* ch = m_sm->hierarchy();
+    if(ch != nullptr){
+        ch->distanceTable(nodes, nodes, table);
+    }
+    else{
+        dijkstraTable(nodes, table);
+    }
+
+    const double milesPerKm = 1 / 1.609344;
+    m_size = nodes.size();
+    m_miles.resize(table.size());
+    for(size_t i = 0; i < table.size(); i++){
+        m_miles[i] = table[i] * milesPerKm;
+    }
+    return DELIVERY_SUCCESS;
+}
+
+void DistanceMatrixImpl::dijkstraTable(const vector<NodeID>& nodes, vector<double>& table) const
+{
+    const StreetGraph& graph = m_sm->graph();
+    int n = nodes.size();
+    table.assign(n * n, numeric_limits<double>::infinity());
+
+    vector<NodeID> wanted(nodes);
+    sort(wanted.begin(), wanted.end());
+    wanted.erase(unique(wanted.begin(), wanted.end()), wanted.end());
+
+    SearchWorkspace& ws = threadWorkspace();
+    for(int s = 0; s < n; s++){
+        ws.start(graph.numNodes());
+        ws.reach(nodes[s], 0, NO_EDGE);
+        ws.heap.pushOrDecrease(nodes[s], 0);
+        int remaining = wanted.size();
+        while(!ws.heap.empty() && remaining > 0){ //done once every point is settled
+            NodeID u = ws.heap.popMin();
+            ws.settle(u);
+            if(binary_search(wanted.begin(), wanted.end(), u)){
+                remaining--;
+            }
+            double du = ws.distance(u);
+            for(EdgeID e : graph.edgesFrom(u)){
+                NodeID v = graph.target(e);
+                double d = du + graph.weight(e);
+                if(d < numeric_limits<double>::infinity() && (!ws.reached(v) || d < ws.distance(v))){ //closed segments lead nowhere
+                    ws.reach(v, d, e);
+                    ws.heap.pushOrDecrease(v, d);
+                }
+            }
+        }
+        for(int t = 0; t < n; t++){
+            if(ws.settled(nodes[t])){
+                table[s * n + t] = ws.distance(nodes[t]);
+            }
+        }
+    }
+}
+
+//******************** DistanceMatrix functions *******************************
+
+// These functions simply delegate to DistanceMatrixImpl's functions.
+
+DistanceMatrix::DistanceMatrix(const StreetMap* sm)
+{
+    m_impl = new DistanceMatrixImpl(sm);
+}
+
+DistanceMatrix::~DistanceMatrix()
+{
+    delete m_impl;
+}
+
+DeliveryResult DistanceMatrix::compute(const vector<GeoCoord>& points)
+{
+    return m_impl->compute(points);
+}
+
+int DistanceMatrix::size() const
+{
+    return m_impl->size();
+}
+
+double DistanceMatrix::distance(int from, int to) const
+{
+    return m_impl->distance(from, to);
+}
+
+bool DistanceMatrix::reachable(int from, int to) const
+{
+    return m_impl->distance(from, to) < numeric_limits<double>::infinity();
+}
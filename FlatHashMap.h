@@ -0,0 +1,285 @@
+#ifndef FLAT_HASH_MAP_h
+#define FLAT_HASH_MAP_h
+
+#include <cstring>
+#include <new>
+#include <utility>
+// FlatHashMap.h
+
+// Open-addressing counterpart of ExpandableHashMap with the same associate /
+// find / reset interface and the same free hasher(const KeyType&) hook.
+// Entries live in one flat array and are placed with Robin Hood linear
+// probing: an insert displaces any entry that is closer to its home slot than
+// the new one, which keeps probe sequences short and lets a lookup stop as
+// soon as it passes the distance where its key would have been.
+//
+// Unlike ExpandableHashMap, inserting hashes once, keys and values can be
+// moved in, growing moves entries instead of copying them, and reset() keeps
+// the allocated capacity so a map can be refilled without allocating.
+// erase() shifts the entries that follow back by one slot instead of leaving
+// a tombstone, so lookups stay as short after removals as before.
+
+template<typename KeyType, typename ValueType>
+class FlatHashMap
+{
+public:
+    FlatHashMap(double maximumLoadFactor = 0.5);
+    ~FlatHashMap();
+    void reset();
+    int size() const;
+    void reserve(int numElements);
+    void associate(const KeyType& key, const ValueType& value) { insert(key, value); }
+    void associate(KeyType&& key, ValueType&& value) { insert(std::move(key), std::move(value)); }
+      // removes key's association, if any; false if there was none
+    bool erase(const KeyType& key);
+
+      // for a map that can't be modified, return a pointer to const ValueType
+    const ValueType* find(const KeyType& key) const
+    {
+        Uncounted none;
+        return find(key, none);
+    }
+
+      // for a modifiable map, return a pointer to modifiable ValueType
+    ValueType* find(const KeyType& key)
+    {
+        return const_cast<ValueType*>(const_cast<const FlatHashMap*>(this)->find(key));
+    }
+
+      // the same, calling counter.probe() for every key compared and
+      // counter.resize() when the table grows (see Statistics.h)
+    template<typename Counter>
+    const ValueType* find(const KeyType& key, Counter& counter) const;
+    template<typename Counter>
+    ValueType* find(const KeyType& key, Counter& counter)
+    {
+        return const_cast<ValueType*>(const_cast<const FlatHashMap*>(this)->find(key, counter));
+    }
+    template<typename Counter>
+    void associate(const KeyType& key, const ValueType& value, Counter& counter)
+    {
+        int capacity = m_capacity;
+        insert(key, value);
+        if(m_capacity != capacity){
+            counter.resize();
+        }
+    }
+
+      // C++11 syntax for preventing copying and assignment
+    FlatHashMap(const FlatHashMap&) = delete;
+    FlatHashMap& operator=(const FlatHashMap&) = delete;
+
+private:
+    struct Bucket{
+        KeyType key;
+        ValueType value;
+    };
+
+    Bucket* m_buckets;          // raw storage, only slots with m_distance != 0 are constructed
+    unsigned char* m_distance;  // 0 = empty, otherwise 1 + distance from the home slot
+    double m_maxLoad;
+    int m_numElements;
+    int m_capacity;             // power of two
+    int m_shift;                // 32 - log2(m_capacity)
+
+    static constexpr int MAX_DISTANCE = 255;
+
+    struct Uncounted{
+        void probe() {}
+    };
+
+    unsigned int homeSlot(const KeyType& key) const;
+    void allocate(int capacity);
+    void grow(int capacity);
+    void destroyAll();
+
+    template<typename K, typename V>
+    void insert(K&& key, V&& value);
+};
+
+template<typename KeyType, typename ValueType>
+FlatHashMap<KeyType, ValueType>::FlatHashMap(double maximumLoadFactor)
+ : m_buckets(nullptr), m_distance(nullptr), m_maxLoad(maximumLoadFactor), m_numElements(0), m_capacity(0), m_shift(32)
+{
+    allocate(8);
+}
+
+template<typename KeyType, typename ValueType>
+FlatHashMap<KeyType, ValueType>::~FlatHashMap()
+{
+    destroyAll();
+    ::operator delete(m_buckets);
+    delete [] m_distance;
+}
+
+template<typename KeyType, typename ValueType>
+void FlatHashMap<KeyType, ValueType>::reset()
+{
+    destroyAll(); //capacity is kept for the next round of inserts
+}
+
+template<typename KeyType, typename ValueType>
+int FlatHashMap<KeyType, ValueType>::size() const
+{
+    return m_numElements;
+}
+
+template<typename KeyType, typename ValueType>
+void FlatHashMap<KeyType, ValueType>::reserve(int numElements)
+{
+    int capacity = m_capacity;
+    while(numElements > capacity * m_maxLoad){
+        capacity *= 2;
+    }
+    if(capacity != m_capacity){
+        grow(capacity);
+    }
+}
+
+template<typename KeyType, typename ValueType>
+template<typename Counter>
+const ValueType* FlatHashMap<KeyType, ValueType>::find(const KeyType& key, Counter& counter) const
+{
+    unsigned int mask = m_capacity - 1;
+    unsigned int slot = homeSlot(key);
+    for(int distance = 1; m_distance[slot] >= distance; distance++){ //past this distance the key would have displaced the entry
+        counter.probe();
+        if(m_buckets[slot].key == key){
+            return &m_buckets[slot].value;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return nullptr;
+}
+
+template<typename KeyType, typename ValueType>
+bool FlatHashMap<KeyType, ValueType>::erase(const KeyType& key)
+{
+    unsigned int mask = m_capacity - 1;
+    unsigned int slot = homeSlot(key);
+    int distance = 1;
+    while(m_distance[slot] >= distance && !(m_buckets[slot].key == key)){
+        slot = (slot + 1) & mask;
+        distance++;
+    }
+    if(m_distance[slot] < distance){
+        return false;
+    }
+
+    m_buckets[slot].~Bucket();
+    unsigned int next = (slot + 1) & mask;
+    while(m_distance[next] > 1){ //pull displaced entries one slot closer to home
+        new (&m_buckets[slot]) Bucket(std::move(m_buckets[next]));
+        m_buckets[next].~Bucket();
+        m_distance[slot] = m_distance[next] - 1;
+        slot = next;
+        next = (next + 1) & mask;
+    }
+    m_distance[slot] = 0;
+    m_numElements--;
+    return true;
+}
+
+template<typename KeyType, typename ValueType>
+unsigned int FlatHashMap<KeyType, ValueType>::homeSlot(const KeyType& key) const
+{
+    unsigned int hasher(const KeyType& k); // prototype
+    unsigned int h = hasher(key);
+    return (h * 2654435769u) >> m_shift; //Fibonacci hashing spreads weak hashes such as small integers over the table
+}
+
+template<typename KeyType, typename ValueType>
+void FlatHashMap<KeyType, ValueType>::allocate(int capacity)
+{
+    m_buckets = static_cast<Bucket*>(::operator new(sizeof(Bucket) * capacity));
+    m_distance = new unsigned char[capacity];
+    memset(m_distance, 0, capacity);
+    m_capacity = capacity;
+    m_numElements = 0;
+    m_shift = 32;
+    for(int c = capacity; c > 1; c /= 2){
+        m_shift--;
+    }
+}
+
+template<typename KeyType, typename ValueType>
+void FlatHashMap<KeyType, ValueType>::grow(int capacity)
+{
+    Bucket* oldBuckets = m_buckets;
+    unsigned char* oldDistance = m_distance;
+    int oldCapacity = m_capacity;
+
+    allocate(capacity);
+    for(int i = 0; i < oldCapacity; i++){ //move every entry into the new table
+        if(oldDistance[i] != 0){
+            insert(std::move(oldBuckets[i].key), std::move(oldBuckets[i].value));
+            oldBuckets[i].~Bucket();
+        }
+    }
+
+    ::operator delete(oldBuckets);
+    delete [] oldDistance;
+}
+
+template<typename KeyType, typename ValueType>
+void FlatHashMap<KeyType, ValueType>::destroyAll()
+{
+    for(int i = 0; i < m_capacity; i++){
+        if(m_distance[i] != 0){
+            m_buckets[i].~Bucket();
+        }
+    }
+    memset(m_distance, 0, m_capacity);
+    m_numElements = 0;
+}
+
+template<typename KeyType, typename ValueType>
+template<typename K, typename V>
+void FlatHashMap<KeyType, ValueType>::insert(K&& key, V&& value)
+{
+    if((m_numElements + 1) > m_capacity * m_maxLoad){
+        grow(m_capacity * 2);
+    }
+
+    unsigned int mask = m_capacity - 1;
+    unsigned int slot = homeSlot(key);
+    int distance = 1;
+
+    //look for the key until its probe distance exceeds the resident entry's; that is also where it belongs
+    while(m_distance[slot] >= distance){
+        if(m_buckets[slot].key == key){
+            m_buckets[slot].value = std::forward<V>(value); //an association with the given key exists, change its value
+            return;
+        }
+        slot = (slot + 1) & mask;
+        distance++;
+    }
+
+    if(distance >= MAX_DISTANCE){ //pathological clustering, spread the table out and try again
+        grow(m_capacity * 2);
+        insert(std::forward<K>(key), std::forward<V>(value));
+        return;
+    }
+
+    Bucket carry{std::forward<K>(key), std::forward<V>(value)};
+    while(m_distance[slot] != 0){ //rich entries give up their slot to the poorer one being carried
+        if(m_distance[slot] < distance){
+            std::swap(carry, m_buckets[slot]);
+            int resident = m_distance[slot];
+            m_distance[slot] = distance;
+            distance = resident;
+        }
+        slot = (slot + 1) & mask;
+        distance++;
+        if(distance >= MAX_DISTANCE){
+            grow(m_capacity * 2);
+            insert(std::move(carry.key), std::move(carry.value));
+            return;
+        }
+    }
+    new (&m_buckets[slot]) Bucket(std::move(carry));
+    m_distance[slot] = distance;
+    m_numElements++;
+}
+
+#endif
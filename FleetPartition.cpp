@@ -0,0 +1,235 @@
+#include "FleetPartition.h"
+#include "NeighborListSearch.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <numeric>
+using namespace std;
+
+namespace {
+
+const double EPSILON = 1e-9;            //smallest gain worth a move, so rounding can't make a search cycle
+
+}
+
+FleetPartition::FleetPartition(const GeoPoints& points, double scale)
+ : m_points(points), m_scale(scale), m_size(points.size())
+{
+}
+
+bool FleetPartition::partition(int numVehicles, const vector<int>& capacities, vector<vector<int> >& routes)
+{
+    routes.assign(numVehicles, vector<int>());
+    int numStops = m_size - 1;
+    if(numVehicles <= 0){
+        return numStops == 0;
+    }
+
+    //balanced shares: vehicles with the smallest capacities are filled first, the rest split what is left evenly
+    vector<int> caps (numVehicles, INT_MAX);
+    for(int v = 0; v < numVehicles && v < (int)capacities.size(); v++){
+        if(capacities[v] > 0){
+            caps[v] = capacities[v];
+        }
+    }
+    vector<int> byCapacity (numVehicles);
+    iota(byCapacity.begin(), byCapacity.end(), 0);
+    stable_sort(byCapacity.begin(), byCapacity.end(), [&](int a, int b){ return caps[a] < caps[b]; });
+    vector<int> shares (numVehicles);
+    int remaining = numStops;
+    for(int k = 0; k < numVehicles; k++){
+        int v = byCapacity[k];
+        int left = numVehicles - k;
+        shares[v] = min(caps[v], (remaining + left - 1) / left);
+        remaining -= shares[v];
+    }
+    if(remaining > 0){
+        return false;
+    }
+    vector<int> limits (numVehicles);
+    for(int v = 0; v < numVehicles; v++){
+        limits[v] = (int)min((long long)caps[v], shares[v] + max(1LL, shares[v] / 10LL));
+    }
+    if(numStops == 0){
+        return true;
+    }
+
+    m_route.assign(m_size, -1);
+    m_index.assign(m_size, -1);
+    sweep(shares, routes);
+    vector<bool> changed (numVehicles, true);
+    optimizeRoutes(routes, changed);
+    if(numVehicles == 1){
+        return true;
+    }
+
+    buildNeighbors();
+    for(int round = 0; round < MAX_ROUNDS; round++){
+        changed.assign(numVehicles, false);
+        if(!exchange(routes, limits, changed)){
+            break;
+        }
+        optimizeRoutes(routes, changed);
+    }
+    return true;
+}
+
+  //cuts the stops, in order of bearing from the depot, into runs of the given lengths
+void FleetPartition::sweep(const vector<int>& shares, vector<vector<int> >& routes)
+{
+    //bearings on a local flat projection around the depot, which is all a sweep needs
+    UnitVector depot = m_points.point(0);
+    double depotLat = asin(max(-1.0, min(1.0, depot.z)));
+    double depotLon = atan2(depot.y, depot.x);
+    vector<pair<double, int> > bearings;
+    for(int i = 1; i < m_size; i++){
+        UnitVector p = m_points.point(i);
+        double lat = asin(max(-1.0, min(1.0, p.z)));
+        double lon = remainder(atan2(p.y, p.x) - depotLon, 2 * M_PI);
+        bearings.push_back(make_pair(atan2(lat - depotLat, lon * cos(depotLat)), i));
+    }
+    sort(bearings.begin(), bearings.end());
+
+    //start after the widest wedge without stops, so no route straddles it
+    int n = bearings.size();
+    int start = 0;
+    double widest = bearings[0].first + 2 * M_PI - bearings[n - 1].first;
+    for(int i = 1; i < n; i++){
+        if(bearings[i].first - bearings[i - 1].first > widest){
+            widest = bearings[i].first - bearings[i - 1].first;
+            start = i;
+        }
+    }
+
+    int k = 0;
+    for(int v = 0; v < (int)shares.size(); v++){
+        for(int j = 0; j < shares[v]; j++, k++){
+            routes[v].push_back(bearings[(start + k) % n].second);
+        }
+        reindex(routes[v], v);
+    }
+}
+
+  //re-orders the changed routes, several at a time
+void FleetPartition::optimizeRoutes(vector<vector<int> >& routes, const vector<bool>& changed)
+{
+    sharedWorkerPool().parallelFor(routes.size(), [&](int r){
+        vector<int>& route = routes[r];
+        if(!changed[r] || route.size() < 2){
+            return;
+        }
+        GeoPoints points;
+        points.reserve(route.size() + 1);
+        points.add(m_points.point(0));
+        for(size_t i = 0; i < route.size(); i++){
+            points.add(m_points.point(route[i]));
+        }
+        vector<int> order (route.size());
+        iota(order.begin(), order.end(), 1);
+        NeighborListSearch(points, m_scale).improve(order);
+        vector<int> stops (route.size());
+        for(size_t i = 0; i < order.size(); i++){
+            stops[i] = route[order[i] - 1];
+        }
+        route.swap(stops);
+        reindex(route, r);
+    });
+}
+
+  //relocates and swaps stops between routes until no such move helps; true if any did
+bool FleetPartition::exchange(vector<vector<int> >& routes, const vector<int>& limits, vector<bool>& changed)
+{
+    bool any = false;
+    bool improved = true;
+    while(improved){
+        improved = false;
+        for(int s = 1; s < m_size; s++){
+            int r = m_route[s];
+            int i = m_index[s];
+            int p = before(routes[r], i);
+            int nx = after(routes[r], i);
+            double removed = dist(p, s) + dist(s, nx) - dist(p, nx);
+            for(int k = 0; k < NUM_NEIGHBORS; k++){
+                int c = m_neighbors[(size_t)s * NUM_NEIGHBORS + k];
+                if(c < 0){
+                    break;
+                }
+                int q = m_route[c];
+                if(q == r){
+                    continue;
+                }
+                vector<int>& other = routes[q];
+                int j = m_index[c];
+                int pc = before(other, j);
+                int nc = after(other, j);
+
+                //move s to just before or just after c
+                int at = -1;
+                if((int)other.size() < limits[q]){
+                    if(dist(pc, s) + dist(s, c) - dist(pc, c) - removed < -EPSILON){
+                        at = j;
+                    }
+                    else if(dist(c, s) + dist(s, nc) - dist(c, nc) - removed < -EPSILON){
+                        at = j + 1;
+                    }
+                }
+                if(at >= 0){
+                    routes[r].erase(routes[r].begin() + i);
+                    other.insert(other.begin() + at, s);
+                    reindex(routes[r], r);
+                    reindex(other, q);
+                }
+                //or s and c trade places
+                else if(dist(p, c) + dist(c, nx) - dist(p, s) - dist(s, nx)
+                      + dist(pc, s) + dist(s, nc) - dist(pc, c) - dist(c, nc) < -EPSILON){
+                    routes[r][i] = c;
+                    other[j] = s;
+                    m_route[c] = r;
+                    m_index[c] = i;
+                    m_route[s] = q;
+                    m_index[s] = j;
+                }
+                else{
+                    continue;
+                }
+                changed[r] = true;
+                changed[q] = true;
+                any = true;
+                improved = true;
+                break;
+            }
+        }
+    }
+    return any;
+}
+
+  //the NUM_NEIGHBORS nearest stops to every stop
+void FleetPartition::buildNeighbors()
+{
+    int k = min(NUM_NEIGHBORS, m_size - 2);
+    m_neighbors.assign((size_t)m_size * NUM_NEIGHBORS, -1);
+    vector<double> row (m_size);
+    vector<int> candidates;
+    for(int a = 1; a < m_size; a++){
+        crowDistancesKM(m_points, m_points.point(a), row.data());
+        candidates.clear();
+        for(int b = 1; b < m_size; b++){
+            if(b != a){
+                candidates.push_back(b);
+            }
+        }
+        partial_sort(candidates.begin(), candidates.begin() + k, candidates.end(), [&](int x, int y){
+            return row[x] < row[y] || (row[x] == row[y] && x < y);
+        });
+        copy(candidates.begin(), candidates.begin() + k, m_neighbors.begin() + (size_t)a * NUM_NEIGHBORS);
+    }
+}
+
+void FleetPartition::reindex(const vector<int>& route, int r)
+{
+    for(int i = 0; i < (int)route.size(); i++){
+        m_route[route[i]] = r;
+        m_index[route[i]] = i;
+    }
+}
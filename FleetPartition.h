@@ -0,0 +1,58 @@
+#ifndef FLEET_PARTITION_INCLUDED
+#define FLEET_PARTITION_INCLUDED
+
+#include "CrowDistance.h"
+#include <vector>
+// FleetPartition.h
+
+// Splits delivery stops among vehicles that share a depot, for
+// DeliveryPlanner::generateFleetPlan.
+//
+// Stops are first swept by bearing from the depot, starting after the widest
+// empty wedge, and cut into consecutive runs of balanced length (no run longer
+// than its vehicle's capacity). Each run is ordered with NeighborListSearch.
+// Then stops change hands between routes while that shortens the routes'
+// total crow length: a stop moves next to one of its nearest stops on another
+// route, or trades places with it. The moved-to routes are re-ordered and the
+// exchange runs again, for at most MAX_ROUNDS rounds. A route may grow by a
+// tenth over its balanced length during the exchange, and never past its
+// capacity, so the largest route, which bounds planning time, stays small.
+class FleetPartition
+{
+public:
+      // points[0] is the depot, the rest are stops; distances are crow
+      // distances times scale
+    FleetPartition(const GeoPoints& points, double scale);
+
+      // routes[v] gets vehicle v's stops in visiting order; capacities[v]
+      // limits how many (0 for no limit, empty for no limits at all). False if
+      // the capacities can't hold every stop.
+    bool partition(int numVehicles, const std::vector<int>& capacities, std::vector<std::vector<int> >& routes);
+
+private:
+    static constexpr int NUM_NEIGHBORS = 8;
+    static constexpr int MAX_ROUNDS = 3;
+
+    const GeoPoints& m_points;
+    double m_scale;
+    int m_size;
+
+    std::vector<int> m_neighbors;       // NUM_NEIGHBORS stops per stop, nearest first
+    std::vector<int> m_route;           // per point, its route (-1 for the depot)
+    std::vector<int> m_index;           // per point, its index in the route
+
+    double dist(int a, int b) const
+    {
+        return m_scale * crowDistanceKM(m_points.point(a), m_points.point(b));
+    }
+
+    void buildNeighbors();
+    void sweep(const std::vector<int>& shares, std::vector<std::vector<int> >& routes);
+    void optimizeRoutes(std::vector<std::vector<int> >& routes, const std::vector<bool>& changed);
+    bool exchange(std::vector<std::vector<int> >& routes, const std::vector<int>& limits, std::vector<bool>& changed);
+    void reindex(const std::vector<int>& route, int r);
+    int before(const std::vector<int>& route, int i) const { return i == 0 ? 0 : route[i - 1]; }
+    int after(const std::vector<int>& route, int i) const { return i + 1 == (int)route.size() ? 0 : route[i + 1]; }
+};
+
+#endif // FLEET_PARTITION_INCLUDED
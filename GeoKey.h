@@ -0,0 +1,134 @@
+#ifndef GEO_KEY_INCLUDED
+#define GEO_KEY_INCLUDED
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+// GeoKey.h
+
+// A coordinate as one 64-bit integer: latitude and longitude in fixed point
+// units of 1e-7 degrees (the map files' precision), 32 bits each. Map nodes
+// are stored as GeoKeys, and coordinates are looked up, hashed and compared as
+// GeoKeys, so none of that needs a string or an allocation.
+//
+// Text converts exactly, without going through floating point: "34.0547"
+// and "34.0547000" are the same key, and a key prints back with exactly
+// seven decimals. Digits past the seventh are rounded, half away from zero.
+const double GEO_KEY_UNITS_PER_DEGREE = 1e7;
+
+struct GeoKey
+{
+    uint64_t bits;
+
+    int32_t latitude() const { return int32_t(uint32_t(bits >> 32)); }
+    int32_t longitude() const { return int32_t(uint32_t(bits)); }
+
+      // degrees; division by a power of ten that is exact in a double gives
+      // the same double as parsing the text would
+    double latitudeDegrees() const { return latitude() / GEO_KEY_UNITS_PER_DEGREE; }
+    double longitudeDegrees() const { return longitude() / GEO_KEY_UNITS_PER_DEGREE; }
+};
+
+inline bool operator==(const GeoKey& a, const GeoKey& b) { return a.bits == b.bits; }
+inline bool operator!=(const GeoKey& a, const GeoKey& b) { return a.bits != b.bits; }
+
+inline GeoKey makeGeoKey(int32_t latitude, int32_t longitude)
+{
+    return GeoKey{ (uint64_t(uint32_t(latitude)) << 32) | uint32_t(longitude) };
+}
+
+  // multiplicative hash folded to 32 bits; stable across runs, since map
+  // images store a table laid out by it
+inline unsigned int hasher(const GeoKey& key)
+{
+    return static_cast<unsigned int>((key.bits * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+  // decimal degrees text ("-118.4794734") to units of 1e-7 degrees; false if
+  // the text isn't a plain decimal number or is out of range
+inline bool parseFixed7(const char* text, size_t length, int32_t& value)
+{
+    size_t i = 0;
+    bool negative = false;
+    if(i < length && (text[i] == '-' || text[i] == '+')){
+        negative = text[i] == '-';
+        i++;
+    }
+    int64_t units = 0;
+    int digits = 0;
+    for(; i < length && text[i] >= '0' && text[i] <= '9'; i++, digits++){
+        units = units * 10 + (text[i] - '0');
+        if(units > 1000){ //no coordinate has more than three integer digits
+            return false;
+        }
+    }
+    int decimals = 0;
+    bool roundUp = false;
+    if(i < length && text[i] == '.'){
+        for(i++; i < length && text[i] >= '0' && text[i] <= '9'; i++, digits++){
+            if(decimals < 7){
+                units = units * 10 + (text[i] - '0');
+                decimals++;
+            }
+            else if(decimals == 7){ //the first digit past the key's precision decides the rounding
+                roundUp = text[i] >= '5';
+                decimals++;
+            }
+        }
+    }
+    if(i != length || digits == 0){
+        return false;
+    }
+    for(; decimals < 7; decimals++){
+        units *= 10;
+    }
+    units += roundUp;
+    if(units > 1800000000){
+        return false;
+    }
+    value = int32_t(negative ? -units : units);
+    return true;
+}
+
+inline bool makeGeoKey(const std::string& latitude, const std::string& longitude, GeoKey& key)
+{
+    int32_t lat, lon;
+    if(!parseFixed7(latitude.data(), latitude.size(), lat) || !parseFixed7(longitude.data(), longitude.size(), lon)){
+        return false;
+    }
+    key = makeGeoKey(lat, lon);
+    return true;
+}
+
+  // writes value (1e-7 degrees) as decimal degrees with seven decimals into
+  // out, which needs room for 14 characters and a nul; returns the length
+inline int formatFixed7(int32_t value, char* out)
+{
+    int64_t v = value;
+    int n = 0;
+    if(v < 0){
+        out[n++] = '-';
+        v = -v;
+    }
+    char digits[12];
+    int count = 0;
+    int64_t whole = v / 10000000;
+    do{
+        digits[count++] = char('0' + whole % 10);
+        whole /= 10;
+    }while(whole > 0);
+    while(count > 0){
+        out[n++] = digits[--count];
+    }
+    out[n++] = '.';
+    int64_t fraction = v % 10000000;
+    for(int d = 6; d >= 0; d--){
+        out[n + d] = char('0' + fraction % 10);
+        fraction /= 10;
+    }
+    n += 7;
+    out[n] = '\0';
+    return n;
+}
+
+#endif // GEO_KEY_INCLUDED
@@ -0,0 +1,235 @@
+#include "provided.h"
+#include "Landmarks.h"
+#include "SearchWorkspace.h"
+#include <vector>
+#include <algorithm>
+using namespace std;
+
+namespace {
+
+  // Dijkstra over the street lengths; nodes that source can't reach keep `unreachable`.
+  // If order is given it receives the nodes in the order they were settled.
+void shortestDistances(const StreetGraph& graph, NodeID source, double unreachable, vector<double>& dist, vector<EdgeID>* parents, vector<NodeID>* order)
+{
+    int numNodes = graph.numNodes();
+    dist.assign(numNodes, unreachable);
+    if(parents != nullptr){
+        parents->assign(numNodes, NO_EDGE);
+    }
+    if(order != nullptr){
+        order->clear();
+    }
+
+    NodeHeap heap;
+    heap.resize(numNodes);
+    dist[source] = 0;
+    heap.pushOrDecrease(source, 0);
+    while(!heap.empty()){
+        NodeID u = heap.popMin();
+        if(order != nullptr){
+            order->push_back(u);
+        }
+        for(EdgeID e : graph.edgesFrom(u)){
+            NodeID v = graph.target(e);
+            double d = dist[u] + graph.length(e);
+            if(d < dist[v]){
+                dist[v] = d;
+                if(parents != nullptr){
+                    (*parents)[v] = e;
+                }
+                heap.pushOrDecrease(v, d);
+            }
+        }
+    }
+}
+
+  // some node of the largest connected piece of the map; landmarks placed there help the most queries
+NodeID nodeInLargestComponent(const StreetGraph& graph)
+{
+    int numNodes = graph.numNodes();
+    vector<int> component(numNodes, -1);
+    vector<NodeID> stack;
+    NodeID best = 0;
+    int bestSize = 0;
+    for(NodeID n = 0; n < numNodes; n++){
+        if(component[n] != -1){
+            continue;
+        }
+        int size = 0;
+        component[n] = n;
+        stack.push_back(n);
+        while(!stack.empty()){
+            NodeID u = stack.back();
+            stack.pop_back();
+            size++;
+            for(EdgeID e : graph.edgesFrom(u)){
+                if(component[graph.target(e)] == -1){
+                    component[graph.target(e)] = n;
+                    stack.push_back(graph.target(e));
+                }
+            }
+        }
+        if(size > bestSize){
+            bestSize = size;
+            best = n;
+        }
+    }
+    return best;
+}
+
+}
+
+LandmarkTable::LandmarkTable(const StreetGraph& graph, int numLandmarks, LandmarkStrategy strategy)
+{
+    vector<vector<double> > tables;
+    if(graph.numNodes() > 0 && numLandmarks > 0){
+        if(strategy == LANDMARKS_AVOID){
+            selectAvoid(graph, numLandmarks, tables);
+        }
+        else{
+            selectFarthest(graph, numLandmarks, tables);
+        }
+    }
+
+    //node-major, so one heuristic evaluation reads a single contiguous row
+    int k = m_landmarks.size();
+    m_distances.resize((size_t)graph.numNodes() * k);
+    for(NodeID n = 0; n < graph.numNodes(); n++){
+        for(int i = 0; i < k; i++){
+            m_distances[(size_t)n * k + i] = tables[i][n];
+        }
+    }
+}
+
+bool LandmarkTable::covers(NodeID end) const
+{
+    size_t k = m_landmarks.size();
+    for(size_t i = 0; i < k; i++){
+        if(m_distances[end * k + i] < UNREACHABLE){
+            return true;
+        }
+    }
+    return false;
+}
+
+  // Each new landmark is the node farthest from the ones chosen so far.
+void LandmarkTable::selectFarthest(const StreetGraph& graph, int count, vector<vector<double> >& tables)
+{
+    int numNodes = graph.numNodes();
+    vector<double> dist;
+    shortestDistances(graph, nodeInLargestComponent(graph), UNREACHABLE, dist, nullptr, nullptr);
+    vector<double> nearest(dist); //distance to the closest landmark so far (to the start node at first)
+
+    while((int)m_landmarks.size() < count){
+        NodeID next = NO_NODE;
+        for(NodeID n = 0; n < numNodes; n++){
+            if(nearest[n] < UNREACHABLE && nearest[n] > 0 && (next == NO_NODE || nearest[n] > nearest[next])){
+                next = n;
+            }
+        }
+        if(next == NO_NODE){
+            break; //every reachable node is already a landmark
+        }
+
+        m_landmarks.push_back(next);
+        tables.push_back(vector<double>());
+        shortestDistances(graph, next, UNREACHABLE, tables.back(), nullptr, nullptr);
+        for(NodeID n = 0; n < numNodes; n++){
+            if(tables.back()[n] < nearest[n] || m_landmarks.size() == 1){
+                nearest[n] = tables.back()[n];
+            }
+        }
+    }
+}
+
+  // The "avoid" strategy: grow a shortest path tree from a root, weigh every node by how
+  // badly the current landmarks bound its distance from the root, and put the next
+  // landmark at the leaf of the heaviest landmark-free branch.
+void LandmarkTable::selectAvoid(const StreetGraph& graph, int count, vector<vector<double> >& tables)
+{
+    int numNodes = graph.numNodes();
+    NodeID seed = nodeInLargestComponent(graph);
+
+    //start from the node farthest from the largest component's seed
+    vector<double> dist;
+    shortestDistances(graph, seed, UNREACHABLE, dist, nullptr, nullptr);
+    NodeID first = seed;
+    for(NodeID n = 0; n < numNodes; n++){
+        if(dist[n] < UNREACHABLE && dist[n] > dist[first]){
+            first = n;
+        }
+    }
+    m_landmarks.push_back(first);
+    tables.push_back(vector<double>());
+    shortestDistances(graph, first, UNREACHABLE, tables.back(), nullptr, nullptr);
+
+    vector<NodeID> reachable;
+    for(NodeID n = 0; n < numNodes; n++){
+        if(tables[0][n] < UNREACHABLE){
+            reachable.push_back(n);
+        }
+    }
+
+    vector<bool> isLandmark(numNodes, false);
+    isLandmark[first] = true;
+    vector<EdgeID> parents;
+    vector<NodeID> order;
+    vector<double> size(numNodes);
+    vector<bool> holdsLandmark(numNodes);
+    unsigned int state = 12345;
+    int attempts = 0;
+
+    while((int)m_landmarks.size() < count && attempts++ < 4 * count){
+        state = state * 1664525u + 1013904223u;
+        NodeID root = reachable[(state >> 8) % reachable.size()];
+        shortestDistances(graph, root, UNREACHABLE, dist, &parents, &order);
+
+        //subtree sizes, children before parents
+        for(size_t i = order.size(); i-- > 0; ){
+            NodeID v = order[i];
+            double lowerBound = 0;
+            for(size_t l = 0; l < tables.size(); l++){
+                double diff = tables[l][v] - tables[l][root];
+                lowerBound = max(lowerBound, diff < 0 ? -diff : diff);
+            }
+            size[v] += dist[v] - lowerBound;
+            holdsLandmark[v] = holdsLandmark[v] || isLandmark[v];
+            if(holdsLandmark[v]){
+                size[v] = 0;
+            }
+            if(parents[v] != NO_EDGE){
+                NodeID p = graph.source(parents[v]);
+                size[p] += size[v];
+                holdsLandmark[p] = holdsLandmark[p] || holdsLandmark[v];
+            }
+        }
+
+        //descend into the heaviest child until reaching a leaf
+        NodeID v = root;
+        for(;;){
+            NodeID heaviest = NO_NODE;
+            for(EdgeID e : graph.edgesFrom(v)){
+                NodeID c = graph.target(e);
+                if(parents[c] == e && !holdsLandmark[c] && size[c] > 0 && (heaviest == NO_NODE || size[c] > size[heaviest])){
+                    heaviest = c;
+                }
+            }
+            if(heaviest == NO_NODE){
+                break;
+            }
+            v = heaviest;
+        }
+        for(size_t i = 0; i < order.size(); i++){
+            size[order[i]] = 0;
+            holdsLandmark[order[i]] = false;
+        }
+
+        if(isLandmark[v]){
+            continue; //unlucky root, every branch already holds a landmark
+        }
+        isLandmark[v] = true;
+        m_landmarks.push_back(v);
+        tables.push_back(vector<double>());
+        shortestDistances(graph, v, UNREACHABLE, tables.back(), nullptr, nullptr);
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef LANDMARKS_INCLUDED
+#define LANDMARKS_INCLUDED
+
+#include "provided.h"
+#include "StreetGraph.h"
+#include <vector>
+#include <cstddef>
+// Landmarks.h
+
+// Landmark distance tables for the ALT heuristic (A*, Landmarks, Triangle
+// inequality), built by StreetMap::buildLandmarks and used by
+// PointToPointRouters created with ROUTE_ALT.
+//
+// For every landmark L the table holds the road distance d(L, v) to every
+// node. Street segments have the same length both ways, so d(v, L) = d(L, v)
+// and the triangle inequality gives |d(L, end) - d(L, v)| <= d(v, end). The
+// heuristic is the largest of these bounds over the landmarks, which on a
+// street grid is much tighter than the straight-line distance and needs no
+// trigonometry.
+//
+// The tables use segment lengths, not the weights set by
+// StreetMap::updateSegmentWeights. Weights never drop below the lengths, so
+// the bounds hold whatever is closed or slowed and need no rebuild; they are
+// only less tight around the changes.
+class LandmarkTable
+{
+public:
+    LandmarkTable(const StreetGraph& graph, int numLandmarks, LandmarkStrategy strategy);
+
+    int numLandmarks() const { return m_landmarks.size(); }
+    NodeID landmark(int i) const { return m_landmarks[i]; }
+    size_t memoryUsage() const { return m_distances.size() * sizeof(double) + m_landmarks.size() * sizeof(NodeID); }
+
+      // true if some landmark reaches end, so bound() is informative for it
+    bool covers(NodeID end) const;
+
+      // lower bound on the road distance from n to end, in kilometers
+    double bound(NodeID n, NodeID end) const
+    {
+        const double* dn = &m_distances[(size_t)n * m_landmarks.size()];
+        const double* de = &m_distances[(size_t)end * m_landmarks.size()];
+        double best = 0;
+        for(size_t i = 0; i < m_landmarks.size(); i++){
+            double diff = de[i] - dn[i]; //infinite when a landmark misses one of them; such a landmark tells nothing
+            if(diff < 0){
+                diff = -diff;
+            }
+            if(diff > best && diff < UNREACHABLE){
+                best = diff;
+            }
+        }
+        return best;
+    }
+
+private:
+    static constexpr double UNREACHABLE = 1e300;
+
+    std::vector<NodeID> m_landmarks;
+    std::vector<double> m_distances;    // node-major: d(landmark i, n) at [n * numLandmarks() + i]
+
+    void selectFarthest(const StreetGraph& graph, int count, std::vector<std::vector<double> >& tables);
+    void selectAvoid(const StreetGraph& graph, int count, std::vector<std::vector<double> >& tables);
+};
+
+#endif // LANDMARKS_INCLUDED
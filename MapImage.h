@@ -0,0 +1,49 @@
+#ifndef MAP_IMAGE_INCLUDED
+#define MAP_IMAGE_INCLUDED
+
+#include <cstdint>
+#include <cstddef>
+// MapImage.h
+
+// Layout of a compiled map image (written by StreetMap::saveImage, read back
+// by StreetMap::load). The image is also the in-memory form of every loaded
+// map: StreetGraph points straight into it, so a compiled map can be mmapped
+// and queried without parsing anything.
+//
+// The file is a MapImageHeader followed by the sections below, each starting
+// on an 8 byte boundary. Bump MAP_IMAGE_VERSION whenever the layout changes.
+
+const char MAP_IMAGE_MAGIC[8] = { 'S', 'M', 'A', 'P', 'I', 'M', 'G', '\0' };
+const uint32_t MAP_IMAGE_VERSION = 3;
+const uint32_t MAP_IMAGE_BYTE_ORDER = 0x01020304;
+
+enum MapImageSection
+{
+    SECTION_COORD_KEYS,         // GeoKey (uint64) per node, see GeoKey.h
+    SECTION_EDGE_OFFSETS,       // int32 per node + 1, CSR row starts
+    SECTION_SOURCES,            // int32 per edge
+    SECTION_TARGETS,            // int32 per edge
+    SECTION_TWINS,              // int32 per edge, the same segment in the opposite direction
+    SECTION_LENGTHS,            // double per edge, kilometers
+    SECTION_EDGE_NAMES,         // int32 per edge into the name table
+    SECTION_NAME_OFFSETS,       // uint32 per interned name into SECTION_NAME_TEXT
+    SECTION_NAME_TEXT,          // nul terminated street names
+    SECTION_COORD_INDEX,        // int32 per slot, open addressed GeoKey -> node id, by hasher(GeoKey)
+    NUM_MAP_IMAGE_SECTIONS
+};
+
+struct MapImageHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t numNodes;
+    uint32_t numEdges;
+    uint32_t numNames;
+    uint32_t indexSlots;        // power of two
+    uint64_t totalSize;
+    uint64_t sectionOffset[NUM_MAP_IMAGE_SECTIONS];
+    uint64_t sectionSize[NUM_MAP_IMAGE_SECTIONS];
+};
+
+#endif // MAP_IMAGE_INCLUDED
@@ -0,0 +1,406 @@
+#include "NeighborListSearch.h"
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <random>
+using namespace std;
+
+namespace {
+
+const double EPSILON = 1e-9;            //smallest gain worth a move, so rounding can't make a search cycle
+const int MAX_SEGMENT = 3;              //longest stretch an Or-opt move carries
+
+}
+
+NeighborListSearch::NeighborListSearch(const vector<double>& table, int size, bool symmetric)
+ : m_table(&table), m_points(nullptr), m_scale(1), m_size(size), m_symmetric(symmetric)
+{
+}
+
+NeighborListSearch::NeighborListSearch(const GeoPoints& points, double scale)
+ : m_table(nullptr), m_points(&points), m_scale(scale), m_size(points.size()), m_symmetric(true)
+{
+}
+
+double NeighborListSearch::tourLength(const vector<int>& stops) const
+{
+    double length = 0;
+    int last = 0;
+    for(size_t i = 0; i < stops.size(); i++){
+        length += dist(last, stops[i]);
+        last = stops[i];
+    }
+    return length + dist(last, 0);
+}
+
+double NeighborListSearch::improve(vector<int>& stops)
+{
+    double given = tourLength(stops);
+    if(m_size < 4){ //at most two stops: every order is as short as any other, or nearly
+        return given;
+    }
+
+    buildNeighbors();
+    nearestNeighborTour();
+
+    m_length = 0;
+    for(int i = 0; i < m_size; i++){
+        m_length += dist(m_tour[i], next(m_tour[i]));
+    }
+    m_active.assign(m_size, true);
+    m_queue.assign(m_tour.begin(), m_tour.end());
+    descend();
+
+    mt19937 generator (5489);
+    vector<int> saved;
+    for(int k = 0; k < m_size && m_size >= 8; k++){
+        saved = m_tour;
+        double savedLength = m_length;
+        kick(generator());
+        descend();
+        if(m_length > savedLength - EPSILON){ //no better: back to the tour before the kick
+            m_tour.swap(saved);
+            for(int i = 0; i < m_size; i++){
+                m_position[m_tour[i]] = i;
+            }
+            m_length = savedLength;
+        }
+    }
+
+    //read the cycle off from the depot, in whichever direction it now runs
+    vector<int> found;
+    found.reserve(m_size - 1);
+    for(int a = next(0); a != 0; a = next(a)){
+        found.push_back(a);
+    }
+    double length = tourLength(found);
+    if(length < given - EPSILON){
+        stops = found;
+        return length;
+    }
+    return given;
+}
+
+  //improves around the active points until none is left
+void NeighborListSearch::descend()
+{
+    while(!m_queue.empty()){
+        int t1 = m_queue.front();
+        m_queue.pop_front();
+        m_active[t1] = false;
+        while((m_symmetric && linKernighanStep(t1)) || orOptStep(t1)){
+            //keep improving around t1 while something works; the moves have re-activated their endpoints
+        }
+    }
+}
+
+  //double bridge: two adjacent stretches of up to MAX_KICK points trade places, keeping their direction
+void NeighborListSearch::kick(unsigned int random)
+{
+    int longest = min(MAX_KICK, (m_size - 2) / 2);
+    int first = 1 + random % longest;
+    random /= longest;
+    int second = 1 + random % longest;
+    random /= longest;
+    int p = random % (m_size - first - second - 1); //x = m_tour[p], then the two stretches, then y
+    int x = m_tour[p];
+    int b1 = m_tour[p + 1];
+    int b2 = m_tour[p + first];
+    int c1 = m_tour[p + first + 1];
+    int c2 = m_tour[p + first + second];
+    int y = m_tour[p + first + second + 1];
+    m_length += dist(x, c1) + dist(c2, b1) + dist(b2, y) - dist(x, b1) - dist(b2, c1) - dist(c2, y);
+    rotate(m_tour.begin() + p + 1, m_tour.begin() + p + first + 1, m_tour.begin() + p + first + second + 1);
+    for(int i = p + 1; i <= p + first + second; i++){
+        m_position[m_tour[i]] = i;
+    }
+    int touched[6] = {x, b1, b2, c1, c2, y};
+    for(int k = 0; k < 6; k++){
+        activate(touched[k]);
+    }
+}
+
+  //the NUM_NEIGHBORS nearest points to every point; the crow kernel does one row at a time
+void NeighborListSearch::buildNeighbors()
+{
+    int k = min(NUM_NEIGHBORS, m_size - 1);
+    m_neighbors.assign((size_t)m_size * NUM_NEIGHBORS, -1);
+    vector<double> row (m_size);
+    vector<int> candidates (m_size - 1);
+    for(int a = 0; a < m_size; a++){
+        if(m_table != nullptr){
+            for(int b = 0; b < m_size; b++){
+                row[b] = dist(a, b);
+            }
+        }
+        else{
+            crowDistancesKM(*m_points, m_points->point(a), row.data());
+        }
+        int c = 0;
+        for(int b = 0; b < m_size; b++){
+            if(b != a){
+                candidates[c++] = b;
+            }
+        }
+        partial_sort(candidates.begin(), candidates.begin() + k, candidates.end(), [&](int x, int y){
+            return row[x] < row[y] || (row[x] == row[y] && x < y);
+        });
+        copy(candidates.begin(), candidates.begin() + k, m_neighbors.begin() + (size_t)a * NUM_NEIGHBORS);
+    }
+}
+
+  //start from the depot and always drive to the nearest point not visited yet, looking at the neighbor list first
+void NeighborListSearch::nearestNeighborTour()
+{
+    m_tour.clear();
+    m_tour.reserve(m_size);
+    m_position.assign(m_size, -1);
+    vector<int> unvisited (m_size - 1);
+    vector<int> slot (m_size);          //index of each unvisited point in unvisited
+    for(int i = 1; i < m_size; i++){
+        unvisited[i - 1] = i;
+        slot[i] = i - 1;
+    }
+
+    int current = 0;
+    for(;;){
+        m_position[current] = m_tour.size();
+        m_tour.push_back(current);
+        if(unvisited.empty()){
+            break;
+        }
+        int nearest = -1;
+        for(int i = 0; i < NUM_NEIGHBORS && nearest == -1; i++){
+            int b = m_neighbors[(size_t)current * NUM_NEIGHBORS + i];
+            if(b >= 0 && m_position[b] < 0){
+                nearest = b;
+            }
+        }
+        if(nearest == -1){
+            double best = numeric_limits<double>::infinity();
+            for(size_t i = 0; i < unvisited.size(); i++){
+                double d = dist(current, unvisited[i]);
+                if(d < best){
+                    best = d;
+                    nearest = unvisited[i];
+                }
+            }
+        }
+        int last = unvisited.back(); //unordered removal from unvisited
+        unvisited[slot[nearest]] = last;
+        slot[last] = slot[nearest];
+        unvisited.pop_back();
+        current = nearest;
+    }
+}
+
+void NeighborListSearch::activate(int a)
+{
+    if(!m_active[a]){
+        m_active[a] = true;
+        m_queue.push_back(a);
+    }
+}
+
+  //reverses the stretch of the cycle from -> ... -> to; reversing everything else instead gives the same
+  //cycle run the other way round, so the shorter of the two is done
+void NeighborListSearch::reversePath(int from, int to)
+{
+    int i = m_position[from];
+    int j = m_position[to];
+    int length = (j - i + m_size) % m_size + 1;
+    if(2 * length > m_size){
+        i = (j + 1) % m_size;
+        j = (m_position[from] - 1 + m_size) % m_size;
+        length = m_size - length;
+    }
+    for(int k = 0; k < length / 2; k++){
+        int a = m_tour[i];
+        int b = m_tour[j];
+        m_tour[i] = b;
+        m_position[b] = i;
+        m_tour[j] = a;
+        m_position[a] = j;
+        i = i + 1 == m_size ? 0 : i + 1;
+        j = j == 0 ? m_size - 1 : j - 1;
+    }
+}
+
+  //2-opt: b follows a and d follows c in the same direction; replaces edges (a,b) and (c,d) by (a,c) and (b,d).
+  //d is implied by the others, so only a, b and c are passed
+void NeighborListSearch::flip(int a, int b, int c)
+{
+    if(next(a) == b){
+        reversePath(b, c);
+    }
+    else{
+        reversePath(c, b);
+    }
+}
+
+  //a chain of flips from t1, each adding an edge to a near point; true if it shortened the tour
+bool NeighborListSearch::linKernighanStep(int t1)
+{
+    int flips[MAX_DEPTH][4];
+    for(int side = 0; side < 2; side++){
+        int t2 = side == 0 ? next(t1) : prev(t1);
+        double gain = dist(t1, t2);     //length removed so far, less the length added, with (t1, t2) open
+        double bestGain = EPSILON;
+        int bestDepth = 0;
+        int depth = 0;
+        while(depth < MAX_DEPTH){
+            //in the direction where t1 follows t2, t4 follows t3: flipping closes the tour with (t2,t3) and (t1,t4)
+            bool forward = next(t2) == t1;
+            int chosen = -1;
+            int chosenT4 = -1;
+            double chosenGain = -numeric_limits<double>::infinity();
+            for(int i = 0; i < NUM_NEIGHBORS; i++){
+                int t3 = m_neighbors[(size_t)t2 * NUM_NEIGHBORS + i];
+                if(t3 < 0){
+                    break;
+                }
+                double g = gain - dist(t2, t3);
+                if(g <= EPSILON){ //neighbors are nearest first, so no later one does better
+                    break;
+                }
+                int t4 = forward ? next(t3) : prev(t3);
+                if(t3 == t1 || t4 == t2 || t4 == t1){
+                    continue;
+                }
+                bool added = false; //never remove an edge this chain has added
+                for(int k = 0; k < depth && !added; k++){
+                    added = (flips[k][0] == t3 && flips[k][2] == t4) || (flips[k][0] == t4 && flips[k][2] == t3)
+                         || (flips[k][1] == t3 && flips[k][3] == t4) || (flips[k][1] == t4 && flips[k][3] == t3);
+                }
+                if(!added && g + dist(t3, t4) > chosenGain){
+                    chosen = t3;
+                    chosenT4 = t4;
+                    chosenGain = g + dist(t3, t4);
+                }
+            }
+            if(chosen < 0){
+                break;
+            }
+            flip(t2, t1, chosen);
+            flips[depth][0] = t2;
+            flips[depth][1] = t1;
+            flips[depth][2] = chosen;
+            flips[depth][3] = chosenT4;
+            depth++;
+            gain = chosenGain;
+            if(gain - dist(chosenT4, t1) > bestGain){
+                bestGain = gain - dist(chosenT4, t1);
+                bestDepth = depth;
+            }
+            t2 = chosenT4;
+        }
+        //undo the flips past the best closed tour, last first
+        while(depth > bestDepth){
+            depth--;
+            flip(flips[depth][0], flips[depth][2], flips[depth][1]);
+        }
+        if(bestDepth > 0){
+            m_length -= bestGain;
+            for(int k = 0; k < bestDepth; k++){
+                for(int e = 0; e < 4; e++){
+                    activate(flips[k][e]);
+                }
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+  //moves the 1 to 3 points starting at t1 between two adjacent points near either end of the stretch
+bool NeighborListSearch::orOptStep(int t1)
+{
+    for(int length = 1; length <= MAX_SEGMENT && length <= m_size - 3; length++){
+        int first = t1;
+        int last = t1;
+        for(int i = 1; i < length; i++){
+            last = next(last);
+        }
+        int before = prev(first);
+        int after = next(last);
+        double removed = dist(before, first) + dist(last, after) - dist(before, after);
+        if(removed <= EPSILON){
+            continue;
+        }
+        for(int end = 0; end < 2; end++){
+            int near = end == 0 ? first : last;
+            for(int i = 0; i < NUM_NEIGHBORS; i++){
+                int c = m_neighbors[(size_t)near * NUM_NEIGHBORS + i];
+                if(c < 0){
+                    break;
+                }
+                bool inside = false;
+                for(int a = first; ; a = next(a)){
+                    inside = inside || a == c;
+                    if(a == last){
+                        break;
+                    }
+                }
+                if(inside){
+                    continue;
+                }
+                //the gap just after c and the one just before it
+                for(int gap = 0; gap < 2; gap++){
+                    int x = gap == 0 ? c : prev(c);
+                    int y = gap == 0 ? next(c) : c;
+                    if(x == last || y == first){ //where the stretch already is
+                        continue;
+                    }
+                    double forwardGain = removed - (dist(x, first) + dist(last, y) - dist(x, y));
+                    double reversedGain = removed - (dist(x, last) + dist(first, y) - dist(x, y));
+                    if(forwardGain > EPSILON){
+                        moveSegment(first, last, x, false);
+                        m_length -= forwardGain;
+                    }
+                    else if(m_symmetric && reversedGain > EPSILON){
+                        moveSegment(first, last, x, true);
+                        m_length -= reversedGain;
+                    }
+                    else{
+                        continue;
+                    }
+                    int touched[6] = {before, after, first, last, x, y};
+                    for(int k = 0; k < 6; k++){
+                        activate(touched[k]);
+                    }
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+  //takes first ... last out of the cycle and puts it between x and the point after it, reversed or not
+void NeighborListSearch::moveSegment(int first, int last, int x, bool reversed)
+{
+    vector<int> segment;
+    for(int a = first; ; a = next(a)){
+        segment.push_back(a);
+        if(a == last){
+            break;
+        }
+    }
+    if(reversed){
+        reverse(segment.begin(), segment.end());
+    }
+
+    //rebuild the cycle starting after the stretch, so it comes out in one piece
+    vector<int> tour;
+    tour.reserve(m_size);
+    for(int a = next(last); a != first; a = next(a)){
+        tour.push_back(a);
+        if(a == x){
+            tour.insert(tour.end(), segment.begin(), segment.end());
+        }
+    }
+    m_tour.swap(tour);
+    for(int i = 0; i < m_size; i++){
+        m_position[m_tour[i]] = i;
+    }
+}
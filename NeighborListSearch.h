@@ -0,0 +1,86 @@
+#ifndef NEIGHBOR_LIST_SEARCH_INCLUDED
+#define NEIGHBOR_LIST_SEARCH_INCLUDED
+
+#include "CrowDistance.h"
+#include <vector>
+#include <deque>
+// NeighborListSearch.h
+
+// Tour improvement for manifests too large for annealing over a full
+// distance table, used by DeliveryOptimizer above LARGE_MANIFEST_STOPS.
+//
+// The tour is a cycle through every point, the depot (point 0) included. Only
+// the NUM_NEIGHBORS nearest points of each point are ever considered as new
+// neighbors for it, and a queue of "active" points (the don't-look bits) makes
+// each pass look only where the last moves changed something. Two moves are
+// tried from every active point:
+//   - a Lin-Kernighan style step: remove a tour edge (t1, t2), add an edge
+//     from t2 to a near point t3, and close the tour again by a 2-opt flip that
+//     removes (t3, t4) and adds (t1, t4); t4 then takes the place of t2 and the
+//     chain continues while its partial gain stays positive, up to MAX_DEPTH
+//     flips. The best closed prefix is kept and the rest is flipped back.
+//   - Or-opt: move a segment of 1 to 3 points between two near points, in
+//     either direction.
+// Flips reverse the shorter side of the cycle, so each costs at most n / 2.
+// Once no move helps, the search is restarted n times around a random
+// double-bridge kick (two short adjacent stretches trade places), which 2-opt
+// style moves cannot undo; a kick is kept only if the tour ends up shorter.
+// The kicks come from a fixed seed, so results are repeatable.
+// With an asymmetric table (road distances) only forward Or-opt moves are
+// used, since reversing part of the tour would change its length.
+class NeighborListSearch
+{
+public:
+      // distances from a row-major size x size table
+    NeighborListSearch(const std::vector<double>& table, int size, bool symmetric);
+      // crow distances between points, scaled (e.g. to miles)
+    NeighborListSearch(const GeoPoints& points, double scale);
+
+      // improves stops, the order after the depot of points 1 ... size - 1, and
+      // returns the tour length; stops is left alone if nothing better is found
+    double improve(std::vector<int>& stops);
+
+    double tourLength(const std::vector<int>& stops) const;
+
+private:
+    static constexpr int NUM_NEIGHBORS = 8;
+    static constexpr int MAX_DEPTH = 5;
+    static constexpr int MAX_KICK = 50;         // longest stretch a kick moves
+
+    const std::vector<double>* m_table;
+    const GeoPoints* m_points;
+    double m_scale;
+    int m_size;
+    bool m_symmetric;
+
+    std::vector<int> m_neighbors;       // NUM_NEIGHBORS per point, nearest first
+    std::vector<int> m_tour;            // the cycle
+    std::vector<int> m_position;        // index in m_tour, per point
+    std::vector<bool> m_active;
+    std::deque<int> m_queue;            // active points
+    double m_length;                    // of the cycle
+
+    double dist(int a, int b) const
+    {
+        if(m_table != nullptr){
+            return (*m_table)[(size_t)a * m_size + b];
+        }
+        return m_scale * crowDistanceKM(m_points->point(a), m_points->point(b));
+    }
+
+    int next(int a) const { return m_tour[m_position[a] + 1 == m_size ? 0 : m_position[a] + 1]; }
+    int prev(int a) const { return m_tour[m_position[a] == 0 ? m_size - 1 : m_position[a] - 1]; }
+
+    void buildNeighbors();
+    void nearestNeighborTour();
+    void activate(int a);
+    void descend();
+    void kick(unsigned int random);
+    void reversePath(int from, int to);
+    void flip(int a, int b, int c);
+    bool linKernighanStep(int t1);
+    bool orOptStep(int t1);
+    void moveSegment(int first, int last, int x, bool reversed);
+};
+
+#endif // NEIGHBOR_LIST_SEARCH_INCLUDED
@@ -1,8 +1,17 @@
 #include "provided.h"
 #include <list>
 #include <iostream>
-#include <queue>
-#include "ExpandableHashMap.h"
+#include "StreetGraph.h"
+#include "SearchWorkspace.h"
+#include "ContractionHierarchy.h"
+#include "Landmarks.h"
+#include "RouteCache.h"
+#include "SpatialIndex.h"
+#include "SpeedProfiles.h"
+#include "Statistics.h"
+#include <vector>
+#include <limits>
+#include <algorithm>
 
 
 using namespace std;
@@ -10,46 +19,103 @@ using namespace std;
 class PointToPointRouterImpl
 {
 public:
-    PointToPointRouterImpl(const StreetMap* sm);
+    PointToPointRouterImpl(const StreetMap* sm, RouteAlgorithm algorithm);
     ~PointToPointRouterImpl();
     DeliveryResult generatePointToPointRoute(
         const GeoCoord& start,
         const GeoCoord& end,
         list<StreetSegment>& route,
         double& totalDistanceTravelled) const;
+    DeliveryResult generateTimedRoute(
+        const GeoCoord& start,
+        const GeoCoord& end,
+        double departure,
+        list<StreetSegment>& route,
+        double& totalDistanceTravelled,
+        double& arrival) const;
+    DeliveryResult generatePointToPointPath(
+        const GeoCoord& start,
+        const GeoCoord& end,
+        vector<EdgeID>& path,
+        double& totalDistanceTravelled) const;
+    DeliveryResult generateTimedPath(
+        const GeoCoord& start,
+        const GeoCoord& end,
+        double departure,
+        vector<EdgeID>& path,
+        double& totalDistanceTravelled,
+        double& arrival) const;
+    void setRouteCache(RouteCache* cache) { m_cache = cache; }
+    void setSnapDistance(double miles) { m_snapMiles = miles; }
+    void setStatistics(Statistics* stats) { m_stats = stats != nullptr ? stats->m_impl : nullptr; }
     
 private:
     const StreetMap* m_sm;
-    struct Node{
-        GeoCoord g;
-        double f_value;
-        double g_value;
-        StreetSegment parent;
-        
-    
-        bool operator< (const Node &other) const{ //the less than operator return true when its value is greater than the other to create a min heap based on the f value of the Node. By default, priority queue is a max heap.
-            if(f_value > other.f_value){
-                return true;
-            }
-            return false;
-        }
-        
-        bool operator>= (const Node &other) const{ //the greater than operater returns true when its value is smaller than the other
-            if(f_value <= other.f_value){
-                return true;
-            }
-            return false;
-        }
+    RouteAlgorithm m_algorithm;
+    RouteCache* m_cache;
+    double m_snapMiles;
+    StatisticsImpl* m_stats;
     
-    };
+    //the public functions pass every query through here, which picks NoCounting or Counting for it (see
+    //Statistics.h); everything below takes the counter as a template parameter
+    template<typename Query>
+    DeliveryResult counted(const Query& query) const;
+    template<typename Counter>
+    DeliveryResult routePath(const GeoCoord& start, const GeoCoord& end, vector<EdgeID>& path,
+                             double& totalDistanceTravelled, Counter& counter) const;
+    template<typename Counter>
+    DeliveryResult timedPath(const GeoCoord& start, const GeoCoord& end, double departure, vector<EdgeID>& path,
+                             double& totalDistanceTravelled, double& arrival, Counter& counter) const;
+    void appendSegments(const vector<EdgeID>& path, list<StreetSegment>& route) const;
+    template<typename Counter>
+    bool findNode(const GeoCoord& gc, NodeID& n, Counter& counter) const;
     
-    void returnPath(const GeoCoord& start, const GeoCoord& end,  ExpandableHashMap<GeoCoord, Node> &closedList, list<StreetSegment>& route, double& totalDistanceTravelled) const;
+    //each search appends the edges of a shortest path to path, or returns false if there is none
+    template<typename Counter>
+    bool search(NodeID startNode, NodeID endNode, vector<EdgeID>& path, Counter& counter) const;
+    template<typename Heuristic, typename Counter>
+    bool aStarRoute(NodeID startNode, NodeID endNode, const Heuristic& heuristic, vector<EdgeID>& path, Counter& counter) const;
+    template<typename Counter>
+    bool bidirectionalRoute(NodeID startNode, NodeID endNode, vector<EdgeID>& path, Counter& counter) const;
+    template<typename Counter>
+    bool timedSearch(NodeID startNode, NodeID endNode, double departure, vector<EdgeID>& path, double& arrival, Counter& counter) const;
+    void returnPath(NodeID start, NodeID end, const SearchWorkspace& ws, vector<EdgeID>& path) const;
     
 };
 
-PointToPointRouterImpl::PointToPointRouterImpl(const StreetMap* sm)
+namespace {
+
+const double INFINITE_WEIGHT = numeric_limits<double>::infinity(); //a closed segment
+
+//A* heuristics: lower bounds on the remaining distance to end, in kilometers. Edge weights are never below
+//the lengths (see StreetGraph::weight), so bounds on distance are bounds on weight as well
+
+struct StraightLineHeuristic
+{
+    StraightLineHeuristic(const StreetGraph& g, NodeID e)
+     : points(g.points()), end(g.points().point(e))
+    {}
+    const GeoPoints& points;
+    UnitVector end;
+    double operator()(NodeID n) const { return crowDistanceKM(points.point(n), end); }
+};
+
+struct LandmarkHeuristic
+{
+    const LandmarkTable& landmarks;
+    NodeID end;
+    double operator()(NodeID n) const { return landmarks.bound(n, end); }
+};
+
+}
+
+PointToPointRouterImpl::PointToPointRouterImpl(const StreetMap* sm, RouteAlgorithm algorithm)
 {
     m_sm = sm;
+    m_algorithm = algorithm;
+    m_cache = nullptr;
+    m_snapMiles = 0;
+    m_stats = nullptr;
 }
 
 PointToPointRouterImpl::~PointToPointRouterImpl()
@@ -58,133 +124,395 @@ PointToPointRouterImpl::~PointToPointRouterImpl()
 
 
 
+  //gc's node, or if gc isn't a vertex, the nearest one within the snap distance
+template<typename Counter>
+bool PointToPointRouterImpl::findNode(const GeoCoord& gc, NodeID& n, Counter& counter) const
+{
+    if(m_sm->graph().findNode(gc, n, counter)){
+        return true;
+    }
+    if(m_snapMiles <= 0){
+        return false;
+    }
+    const double kmPerMile = 1.609344;
+    n = m_sm->spatialIndex().nearestNode(gc.latitude, gc.longitude, m_snapMiles * kmPerMile);
+    return n != NO_NODE;
+}
+
 DeliveryResult PointToPointRouterImpl::generatePointToPointRoute(
         const GeoCoord& start,
         const GeoCoord& end,
-        list<StreetSegment>& route ,
+        list<StreetSegment>& route,
         double& totalDistanceTravelled) const
 {
+    return counted([&](auto& counter){
+        thread_local vector<EdgeID> path;
+        DeliveryResult result = routePath(start, end, path, totalDistanceTravelled, counter);
+        if(result == DELIVERY_SUCCESS){
+            appendSegments(path, route);
+        }
+        return result;
+    });
+}
+
+DeliveryResult PointToPointRouterImpl::generateTimedRoute(
+        const GeoCoord& start,
+        const GeoCoord& end,
+        double departure,
+        list<StreetSegment>& route,
+        double& totalDistanceTravelled,
+        double& arrival) const
+{
+    return counted([&](auto& counter){
+        thread_local vector<EdgeID> path;
+        DeliveryResult result = timedPath(start, end, departure, path, totalDistanceTravelled, arrival, counter);
+        if(result == DELIVERY_SUCCESS){
+            appendSegments(path, route);
+        }
+        return result;
+    });
+}
+
+DeliveryResult PointToPointRouterImpl::generatePointToPointPath(
+        const GeoCoord& start,
+        const GeoCoord& end,
+        vector<EdgeID>& path,
+        double& totalDistanceTravelled) const
+{
+    return counted([&](auto& counter){
+        return routePath(start, end, path, totalDistanceTravelled, counter);
+    });
+}
+
+DeliveryResult PointToPointRouterImpl::generateTimedPath(
+        const GeoCoord& start,
+        const GeoCoord& end,
+        double departure,
+        vector<EdgeID>& path,
+        double& totalDistanceTravelled,
+        double& arrival) const
+{
+    return counted([&](auto& counter){
+        return timedPath(start, end, departure, path, totalDistanceTravelled, arrival, counter);
+    });
+}
+
+template<typename Query>
+DeliveryResult PointToPointRouterImpl::counted(const Query& query) const
+{
+    if(m_stats == nullptr){
+        NoCounting none;
+        return query(none);
+    }
+    ScopedLatency timer (m_stats, STAT_ROUTE_TIME);
+    Counting counting;
+    DeliveryResult result = query(counting);
+    m_stats->add(counting);
+    return result;
+}
+
+  //StreetSegments are only built here, once the path is known
+void PointToPointRouterImpl::appendSegments(const vector<EdgeID>& path, list<StreetSegment>& route) const
+{
+    const StreetGraph& graph = m_sm->graph();
+    for(size_t i = 0; i < path.size(); i++){
+        route.push_back(graph.segment(path[i]));
+    }
+}
+
+template<typename Counter>
+DeliveryResult PointToPointRouterImpl::routePath(
+        const GeoCoord& start,
+        const GeoCoord& end,
+        vector<EdgeID>& path,
+        double& totalDistanceTravelled,
+        Counter& counter) const
+{
+    path.clear();
     
-    //If start is the same as end
-    if(start == end){
-        totalDistanceTravelled = 0;
-        return DELIVERY_SUCCESS;
+    //checking for bad coord; past this point the search only works on node ids
+    const StreetGraph& graph = m_sm->graph();
+    NodeID startNode, endNode;
+    if(!findNode(start, startNode, counter) || !findNode(end, endNode, counter)){
+        return BAD_COORD;
     }
     
+    totalDistanceTravelled = 0;
     
-    //checking for bad coord
-    vector<StreetSegment> segs;
-    if(m_sm->getSegmentsThatStartWith(start, segs) == false|| m_sm->getSegmentsThatStartWith(end, segs) == false){
-        return BAD_COORD;
+    //If start is the same as end; compared as nodes, since one point can be written several ways
+    if(startNode == endNode){
+        return DELIVERY_SUCCESS;
     }
     
-    //creating a heap and map for openlist (for positions that you have yet to explore)
-    priority_queue<Node> openListQueue;
-    ExpandableHashMap<GeoCoord, Node> openListMap;
-
-    //creating a map for closedlist
-    ExpandableHashMap<GeoCoord, Node> closedList;
+    bool found;
+    double miles = 0;
+    RouteCacheImpl* cache = m_cache != nullptr ? m_cache->m_impl : nullptr;
+    if(cache == nullptr || !cache->lookup(m_sm->version(), startNode, endNode, path, found, miles, counter)){
+        found = search(startNode, endNode, path, counter);
+        for(size_t i = 0; i < path.size(); i++){
+            miles += graph.lengthMiles(path[i]);
+        }
+        if(cache != nullptr){
+            cache->store(m_sm->version(), startNode, endNode, path, found, miles, counter);
+        }
+    }
+    if(!found){
+        return NO_ROUTE;
+    }
+    totalDistanceTravelled = miles;
+    return DELIVERY_SUCCESS;
+}
 
+template<typename Counter>
+DeliveryResult PointToPointRouterImpl::timedPath(
+        const GeoCoord& start,
+        const GeoCoord& end,
+        double departure,
+        vector<EdgeID>& path,
+        double& totalDistanceTravelled,
+        double& arrival,
+        Counter& counter) const
+{
+    path.clear();
     totalDistanceTravelled = 0;
-    Node startNode;
-    startNode.g = start;
-    startNode.f_value = 0;
-    startNode.g_value = 0;
-    openListQueue.push(startNode);
-    openListMap.associate(startNode.g, startNode);
-
-
-
-    while(!openListQueue.empty()){
-
-        //find Node with lowest f value
-        Node q = openListQueue.top(); //current position that we will explore in this iteration
-
-        openListQueue.pop();
-        Node* n = openListMap.find(q.g);
-        n->f_value = -1; //-1 signifies a deleted value from the map
+    arrival = departure;
+    
+    const StreetGraph& graph = m_sm->graph();
+    NodeID startNode, endNode;
+    if(!findNode(start, startNode, counter) || !findNode(end, endNode, counter)){
+        return BAD_COORD;
+    }
+    if(startNode == endNode){
+        return DELIVERY_SUCCESS;
+    }
+    
+    //routes depend on the departure time, so they bypass the cache
+    if(!timedSearch(startNode, endNode, departure, path, arrival, counter)){
+        return NO_ROUTE;
+    }
+    for(size_t i = 0; i < path.size(); i++){
+        totalDistanceTravelled += graph.lengthMiles(path[i]);
+    }
+    return DELIVERY_SUCCESS;
+}
 
-        vector<StreetSegment> successors; //vector to hold the successors from the current position
-        m_sm->getSegmentsThatStartWith(q.g, successors);
+template<typename Counter>
+bool PointToPointRouterImpl::search(NodeID startNode, NodeID endNode, vector<EdgeID>& path, Counter& counter) const
+{
+    const StreetGraph& graph = m_sm->graph();
+    const ContractionHierarchy* ch = m_sm->hierarchy();
+    if(m_algorithm == ROUTE_CONTRACTION_HIERARCHY && ch != nullptr){
+        return ch->route(startNode, endNode, path, counter);
+    }
+    if(m_algorithm == ROUTE_BIDIRECTIONAL_ASTAR){
+        return bidirectionalRoute(startNode, endNode, path, counter);
+    }
+    const LandmarkTable* landmarks = m_sm->landmarks();
+    if(m_algorithm == ROUTE_ALT && landmarks != nullptr && landmarks->covers(endNode)){
+        return aStarRoute(startNode, endNode, LandmarkHeuristic{*landmarks, endNode}, path, counter);
+    }
+    return aStarRoute(startNode, endNode, StraightLineHeuristic(graph, endNode), path, counter);
+}
 
+template<typename Heuristic, typename Counter>
+bool PointToPointRouterImpl::aStarRoute(NodeID startNode, NodeID endNode, const Heuristic& heuristic, vector<EdgeID>& path, Counter& counter) const
+{
+    const StreetGraph& graph = m_sm->graph();
+    
+    //A*: the heap holds the open list keyed on f = g + h, settled nodes form the closed list
+    SearchWorkspace& ws = threadWorkspace();
+    ws.start(graph.numNodes());
+    ws.reach(startNode, 0, NO_EDGE);
+    ws.heap.pushOrDecrease(startNode, heuristic(startNode));
+    counter.push(false);
+
+    while(!ws.heap.empty()){
+
+        //the open node with the lowest f value
+        NodeID q = ws.heap.popMin();
+        ws.settle(q);
+        counter.pop();
+        counter.settle();
+        
+        if(q == endNode){ //path found, end search
+            returnPath(startNode, endNode, ws, path); //retracing steps to return the path
+            return true;
+        }
 
-        for(int i = 0; i < successors.size(); i++){
-            if(successors[i].end == end){ //path found, end search
-                //adding last nodes to closed list
-                Node endNode;
-                endNode.g = successors[i].end;
-                endNode.parent = successors[i];
+        //the successors of the current position are its outgoing edges
+        for(EdgeID e : graph.edgesFrom(q)){
+            NodeID successor = graph.target(e);
+            
+            //both heuristics are consistent, so a settled node already has its shortest distance
+            if(ws.settled(successor)){
+                continue;
+            }
 
-                closedList.associate(endNode.g, endNode);
-                
-                closedList.associate(q.g, q);
-                
-                returnPath(start, end, closedList, route, totalDistanceTravelled); //retracing steps to return the path
-                return DELIVERY_SUCCESS;
+            double g = ws.distance(q) + graph.weight(e);
+            if(g == INFINITE_WEIGHT || (ws.reached(successor) && ws.distance(successor) <= g)){ //closed, or no shorter
+                continue;
             }
+            
+            if(!ws.hasHeuristic(successor)){
+                ws.setHeuristic(successor, heuristic(successor));
+            }
+            
+            //a shorter way to the successor: record it and queue it, or move it up if already queued
+            ws.reach(successor, g, e);
+            counter.push(ws.heap.contains(successor));
+            ws.heap.pushOrDecrease(successor, g + ws.heuristic(successor));
+        }
 
-            //calculating the f value for the current successors
-            double g = q.g_value + distanceEarthKM(q.g, successors[i].end);
-            double h = distanceEarthKM(successors[i].end, end);
-            double f = g + h;
+    }
 
-            bool skip_this_successor = false;
+    //all attempts have been exhausted and there is no route
+    return false;
+}
 
-            //if the position exists in openList with a smaller f value, skip this successor
-            Node* found_in_openList = openListMap.find(successors[i].end);
-            if(found_in_openList != nullptr && found_in_openList->f_value != -1  && found_in_openList->f_value < f  ){ //is already in openlist, skip
-                skip_this_successor = true;
+template<typename Counter>
+bool PointToPointRouterImpl::bidirectionalRoute(NodeID startNode, NodeID endNode, vector<EdgeID>& path, Counter& counter) const
+{
+    //the two searches would otherwise meet on an edge out of the node and back
+    if(startNode == endNode){
+        return true;
+    }
+    
+    const StreetGraph& graph = m_sm->graph();
+    
+    //both searches use the average potential p(v) = (h_end(v) - h_start(v)) / 2, forward keys are g + p and
+    //backward keys are g - p. Both then see the same nonnegative reduced edge lengths, so they are two halves
+    //of one Dijkstra and the best path is known once the two smallest keys add up to at least its length
+    SearchWorkspace& forward = threadWorkspace(0);
+    SearchWorkspace& backward = threadWorkspace(1);
+    forward.start(graph.numNodes());
+    backward.start(graph.numNodes());
+    
+    double best = numeric_limits<double>::infinity();
+    NodeID meet = NO_NODE;
+    
+    SearchWorkspace* sides[2] = { &forward, &backward };
+    for(int side = 0; side < 2; side++){
+        NodeID n = side == 0 ? startNode : endNode;
+        double p = (graph.distanceKM(n, endNode) - graph.distanceKM(startNode, n)) / 2;
+        sides[side]->setHeuristic(n, p);
+        sides[side]->reach(n, 0, NO_EDGE);
+        sides[side]->heap.pushOrDecrease(n, side == 0 ? p : -p);
+        counter.push(false);
+    }
+    
+    bool isForward = false;
+    while(!forward.heap.empty() && !backward.heap.empty()){
+        if(forward.heap.minKey() + backward.heap.minKey() >= best){ //no path through an unsettled node can be shorter
+            break;
+        }
+        
+        isForward = !isForward; //alternate between the two sides
+        SearchWorkspace& ws = isForward ? forward : backward;
+        const SearchWorkspace& other = isForward ? backward : forward;
+        
+        NodeID q = ws.heap.popMin();
+        ws.settle(q);
+        counter.pop();
+        counter.settle();
+        
+        for(EdgeID out : graph.edgesFrom(q)){
+            //the backward search walks segments in reverse, so it uses the twin that ends at q
+            EdgeID e = isForward ? out : graph.twin(out);
+            NodeID successor = graph.target(out);
+            if(ws.settled(successor)){
+                continue;
             }
-
-            if(skip_this_successor){
+            
+            double g = ws.distance(q) + graph.weight(e);
+            if(g == INFINITE_WEIGHT || (ws.reached(successor) && ws.distance(successor) <= g)){
                 continue;
             }
-
-            //if this position is in the closed list and has a smaller f value, skip this successor
-            Node* found_in_closedList = closedList.find(successors[i].end);
-            if(found_in_closedList != nullptr  && found_in_closedList->f_value < f  ){
-                skip_this_successor = true;
+            
+            if(!ws.hasHeuristic(successor)){
+                ws.setHeuristic(successor, (graph.distanceKM(successor, endNode) - graph.distanceKM(startNode, successor)) / 2);
             }
-
-            //if this successor is not skipped, add it to the open list
-            if(!skip_this_successor){
-                Node newNode;
-                newNode.f_value = f;
-                newNode.g_value = g;
-                newNode.g = successors[i].end;
-                newNode.parent = successors[i];
-                openListQueue.push(newNode);
-                openListMap.associate(newNode.g, newNode);
-                
-                
+            ws.reach(successor, g, e);
+            counter.push(ws.heap.contains(successor));
+            ws.heap.pushOrDecrease(successor, isForward ? g + ws.heuristic(successor) : g - ws.heuristic(successor));
+            
+            if(other.reached(successor) && g + other.distance(successor) < best){ //the two searches touch here
+                best = g + other.distance(successor);
+                meet = successor;
             }
         }
-        //add q to the closed list because it has been explored
-        closedList.associate(q.g, q);
-
     }
-
-    //all attempts have been exhausted and there is no route
-    return NO_ROUTE;
+    
+    if(meet == NO_NODE){
+        return false;
+    }
+    
+    //start -> meet from the forward parents, meet -> end from the backward ones
+    returnPath(startNode, meet, forward, path);
+    for(NodeID n = meet; n != endNode; n = graph.target(backward.parent(n))){
+        path.push_back(backward.parent(n));
+    }
+    return true;
 }
 
-void PointToPointRouterImpl::returnPath(const GeoCoord& start, const GeoCoord& end,  ExpandableHashMap<GeoCoord, Node> &closedList, list<StreetSegment>& route, double& totalDistanceTravelled) const{
+  //A* where the distance to a node is the time of arriving there, and an edge takes however long its speed profile
+  //says at the time it is entered. Profiles are FIFO, and the heuristic (the straight line at the top speed of any
+  //profile) is consistent, so the first time end is settled is its earliest arrival
+template<typename Counter>
+bool PointToPointRouterImpl::timedSearch(NodeID startNode, NodeID endNode, double departure, vector<EdgeID>& path, double& arrival, Counter& counter) const
+{
+    const StreetGraph& graph = m_sm->graph();
+    const SpeedProfiles& speeds = m_sm->speedProfiles();
+    StraightLineHeuristic straightLine (graph, endNode);
+    double minutesPerKm = 1 / speeds.maxSpeed();
     
-    //starting from the end note, use the parent pointers to recreate the path that it took to get to the solution
-
-    GeoCoord toFind = end;
-    Node* node = closedList.find(toFind);
+    SearchWorkspace& ws = threadWorkspace();
+    ws.start(graph.numNodes());
+    ws.reach(startNode, departure, NO_EDGE);
+    ws.heap.pushOrDecrease(startNode, departure + straightLine(startNode) * minutesPerKm);
+    counter.push(false);
+    
+    while(!ws.heap.empty()){
+        NodeID q = ws.heap.popMin();
+        ws.settle(q);
+        counter.pop();
+        counter.settle();
+        if(q == endNode){
+            returnPath(startNode, endNode, ws, path);
+            arrival = ws.distance(endNode);
+            return true;
+        }
+        
+        for(EdgeID e : graph.edgesFrom(q)){
+            NodeID successor = graph.target(e);
+            if(ws.settled(successor) || graph.weight(e) == INFINITE_WEIGHT){
+                continue;
+            }
+            
+            double t = speeds.arrival(e, graph.weight(e), ws.distance(q));
+            if(ws.reached(successor) && ws.distance(successor) <= t){
+                continue;
+            }
+            if(!ws.hasHeuristic(successor)){
+                ws.setHeuristic(successor, straightLine(successor) * minutesPerKm);
+            }
+            ws.reach(successor, t, e);
+            counter.push(ws.heap.contains(successor));
+            ws.heap.pushOrDecrease(successor, t + ws.heuristic(successor));
+        }
+    }
+    return false;
+}
 
-    while(node->parent.start != start){
-        route.push_front(node->parent);
-        totalDistanceTravelled += distanceEarthMiles(node->parent.end, node->parent.start);
-        toFind = node->parent.start;
+void PointToPointRouterImpl::returnPath(NodeID start, NodeID end, const SearchWorkspace& ws, vector<EdgeID>& path) const{
+    
+    //starting from the end node, use the parent edges to recreate the path that it took to get to the solution
+    const StreetGraph& graph = m_sm->graph();
 
-        node = closedList.find(toFind);
+    size_t first = path.size();
+    for(NodeID n = end; n != start; n = graph.source(ws.parent(n))){
+        path.push_back(ws.parent(n));
     }
-    
-    totalDistanceTravelled += distanceEarthMiles(node->parent.end, node->parent.start);
-    route.push_front(node->parent);
+    reverse(path.begin() + first, path.end());
 
 }
 
@@ -193,9 +521,9 @@ void PointToPointRouterImpl::returnPath(const GeoCoord& start, const GeoCoord& e
 // These functions simply delegate to PointToPointRouterImpl's functions.
 // You probably don't want to change any of this code.
 
-PointToPointRouter::PointToPointRouter(const StreetMap* sm)
+PointToPointRouter::PointToPointRouter(const StreetMap* sm, RouteAlgorithm algorithm)
 {
-    m_impl = new PointToPointRouterImpl(sm);
+    m_impl = new PointToPointRouterImpl(sm, algorithm);
 }
 
 PointToPointRouter::~PointToPointRouter()
@@ -212,3 +540,49 @@ DeliveryResult PointToPointRouter::generatePointToPointRoute(
     return m_impl->generatePointToPointRoute(start, end, route, totalDistanceTravelled);
 }
 
+DeliveryResult PointToPointRouter::generateTimedRoute(
+        const GeoCoord& start,
+        const GeoCoord& end,
+        double departure,
+        list<StreetSegment>& route,
+        double& totalDistanceTravelled,
+        double& arrival) const
+{
+    return m_impl->generateTimedRoute(start, end, departure, route, totalDistanceTravelled, arrival);
+}
+
+DeliveryResult PointToPointRouter::generatePointToPointPath(
+        const GeoCoord& start,
+        const GeoCoord& end,
+        vector<EdgeID>& path,
+        double& totalDistanceTravelled) const
+{
+    return m_impl->generatePointToPointPath(start, end, path, totalDistanceTravelled);
+}
+
+DeliveryResult PointToPointRouter::generateTimedPath(
+        const GeoCoord& start,
+        const GeoCoord& end,
+        double departure,
+        vector<EdgeID>& path,
+        double& totalDistanceTravelled,
+        double& arrival) const
+{
+    return m_impl->generateTimedPath(start, end, departure, path, totalDistanceTravelled, arrival);
+}
+
+void PointToPointRouter::setRouteCache(RouteCache* cache)
+{
+    m_impl->setRouteCache(cache);
+}
+
+void PointToPointRouter::setSnapDistance(double miles)
+{
+    m_impl->setSnapDistance(miles);
+}
+
+void PointToPointRouter::setStatistics(Statistics* stats)
+{
+    m_impl->setStatistics(stats);
+}
+
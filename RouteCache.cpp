@@ -0,0 +1,196 @@
+#include "provided.h"
+#include "RouteCache.h"
+#include <vector>
+#include <mutex>
+#include <algorithm>
+using namespace std;
+
+unsigned int hasher(const uint64_t& key)
+{
+    return (key * 0x9E3779B97F4A7C15ull) >> 32;
+}
+
+namespace {
+
+uint64_t routeKey(NodeID start, NodeID end)
+{
+    return ((uint64_t)(uint32_t)start << 32) | (uint32_t)end;
+}
+
+}
+
+RouteCacheImpl::RouteCacheImpl(int capacity)
+ : m_shards(max(1, min(MAX_SHARDS, capacity))), m_hits(0), m_misses(0)
+{
+    m_shardCapacity = max(1, capacity / (int)m_shards.size());
+    for(size_t i = 0; i < m_shards.size(); i++){
+        m_shards[i].reset(0);
+    }
+}
+
+RouteCacheImpl::Shard& RouteCacheImpl::shardFor(uint64_t key)
+{
+    return m_shards[hasher(key) % m_shards.size()];
+}
+
+void RouteCacheImpl::Shard::unlink(int i)
+{
+    Entry& e = entries[i];
+    if(e.newer != -1){
+        entries[e.newer].older = e.older;
+    }
+    else{
+        newest = e.older;
+    }
+    if(e.older != -1){
+        entries[e.older].newer = e.newer;
+    }
+    else{
+        oldest = e.newer;
+    }
+}
+
+void RouteCacheImpl::Shard::pushNewest(int i)
+{
+    Entry& e = entries[i];
+    e.newer = -1;
+    e.older = newest;
+    if(newest != -1){
+        entries[newest].newer = i;
+    }
+    newest = i;
+    if(oldest == -1){
+        oldest = i;
+    }
+}
+
+void RouteCacheImpl::Shard::reset(unsigned int mapVersion)
+{
+    version = mapVersion;
+    slots.reset();
+    entries.clear();
+    newest = -1;
+    oldest = -1;
+}
+
+template<typename Counter>
+bool RouteCacheImpl::lookup(unsigned int mapVersion, NodeID start, NodeID end, vector<EdgeID>& path, bool& found, double& miles, Counter& counter)
+{
+    uint64_t key = routeKey(start, end);
+    Shard& shard = shardFor(key);
+    lock_guard<mutex> guard(shard.lock);
+    
+    if(shard.version != mapVersion){ //everything in here was routed on an older map
+        shard.reset(mapVersion);
+    }
+    const int* slot = shard.slots.find(key, counter);
+    if(slot == nullptr){
+        m_misses++;
+        return false;
+    }
+    
+    //a hit becomes the most recently used entry
+    shard.unlink(*slot);
+    shard.pushNewest(*slot);
+    const Entry& e = shard.entries[*slot];
+    path.assign(e.path.begin(), e.path.end());
+    found = e.found;
+    miles = e.miles;
+    m_hits++;
+    return true;
+}
+
+template<typename Counter>
+void RouteCacheImpl::store(unsigned int mapVersion, NodeID start, NodeID end, const vector<EdgeID>& path, bool found, double miles, Counter& counter)
+{
+    uint64_t key = routeKey(start, end);
+    Shard& shard = shardFor(key);
+    lock_guard<mutex> guard(shard.lock);
+    
+    if(shard.version != mapVersion){
+        shard.reset(mapVersion);
+    }
+    int* existing = shard.slots.find(key, counter);
+    int i;
+    if(existing != nullptr){ //another thread routed the same leg meanwhile
+        i = *existing;
+        shard.unlink(i);
+    }
+    else if((int)shard.entries.size() < m_shardCapacity){
+        i = shard.entries.size();
+        shard.entries.push_back(Entry());
+        shard.slots.associate(key, i, counter);
+    }
+    else{ //full, so reuse the least recently used entry
+        i = shard.oldest;
+        shard.unlink(i);
+        shard.slots.erase(shard.entries[i].key);
+        shard.slots.associate(key, i, counter);
+    }
+    
+    Entry& e = shard.entries[i];
+    e.key = key;
+    e.found = found;
+    e.miles = miles;
+    e.path.assign(path.begin(), path.end());
+    shard.pushNewest(i);
+}
+
+template bool RouteCacheImpl::lookup(unsigned int, NodeID, NodeID, vector<EdgeID>&, bool&, double&, NoCounting&);
+template bool RouteCacheImpl::lookup(unsigned int, NodeID, NodeID, vector<EdgeID>&, bool&, double&, Counting&);
+template void RouteCacheImpl::store(unsigned int, NodeID, NodeID, const vector<EdgeID>&, bool, double, NoCounting&);
+template void RouteCacheImpl::store(unsigned int, NodeID, NodeID, const vector<EdgeID>&, bool, double, Counting&);
+
+int RouteCacheImpl::size() const
+{
+    int total = 0;
+    for(size_t i = 0; i < m_shards.size(); i++){
+        lock_guard<mutex> guard(m_shards[i].lock);
+        total += m_shards[i].entries.size();
+    }
+    return total;
+}
+
+void RouteCacheImpl::clear()
+{
+    for(size_t i = 0; i < m_shards.size(); i++){
+        lock_guard<mutex> guard(m_shards[i].lock);
+        m_shards[i].reset(m_shards[i].version);
+    }
+    m_hits = 0;
+    m_misses = 0;
+}
+
+//******************** RouteCache functions ***********************************
+
+// These functions simply delegate to RouteCacheImpl's functions.
+
+RouteCache::RouteCache(int capacity)
+{
+    m_impl = new RouteCacheImpl(capacity);
+}
+
+RouteCache::~RouteCache()
+{
+    delete m_impl;
+}
+
+long long RouteCache::hits() const
+{
+    return m_impl->hits();
+}
+
+long long RouteCache::misses() const
+{
+    return m_impl->misses();
+}
+
+int RouteCache::size() const
+{
+    return m_impl->size();
+}
+
+void RouteCache::clear()
+{
+    m_impl->clear();
+}
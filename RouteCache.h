@@ -0,0 +1,75 @@
+#ifndef ROUTE_CACHE_INCLUDED
+#define ROUTE_CACHE_INCLUDED
+
+#include "provided.h"
+#include "FlatHashMap.h"
+#include "Statistics.h"
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+// RouteCache.h
+
+// Implementation of the public RouteCache, used by PointToPointRouterImpl.
+//
+// Routes are keyed on (start node, end node) and stored as the edge ids of
+// the path, which is all a router needs to rebuild the StreetSegments. Routes
+// that don't exist are cached too, since proving that takes the longest
+// search of all. The cache is split into shards by key, each an LRU list
+// threaded through a fixed array of entries with its own lock, so routers on
+// different threads rarely wait on each other. Every shard remembers the
+// StreetMap version it was filled from and empties itself when asked about
+// another one.
+class RouteCacheImpl
+{
+public:
+    RouteCacheImpl(int capacity);
+
+      // on a hit, replaces path with the cached edges of start -> end and sets found
+      // (false for a cached "no route") and miles; false on a miss. counter sees
+      // the probes and resizes of the shard's table (see Statistics.h); both are
+      // instantiated for NoCounting and Counting.
+    template<typename Counter>
+    bool lookup(unsigned int mapVersion, NodeID start, NodeID end, std::vector<EdgeID>& path, bool& found, double& miles, Counter& counter);
+    template<typename Counter>
+    void store(unsigned int mapVersion, NodeID start, NodeID end, const std::vector<EdgeID>& path, bool found, double miles, Counter& counter);
+
+    long long hits() const { return m_hits; }
+    long long misses() const { return m_misses; }
+    int size() const;
+    void clear();
+
+private:
+    struct Entry{
+        uint64_t key;
+        int newer;                  // neighbors in the shard's LRU list, -1 at either end
+        int older;
+        bool found;
+        double miles;
+        std::vector<EdgeID> path;
+    };
+
+    struct Shard{
+        mutable std::mutex lock;
+        unsigned int version;
+        FlatHashMap<uint64_t, int> slots;   // key -> index in entries
+        std::vector<Entry> entries;         // grows up to the shard capacity, then slots are reused
+        int newest;
+        int oldest;
+
+        void unlink(int i);
+        void pushNewest(int i);
+        void reset(unsigned int mapVersion);
+    };
+
+    static constexpr int MAX_SHARDS = 16;
+
+    std::vector<Shard> m_shards;
+    int m_shardCapacity;
+    std::atomic<long long> m_hits;
+    std::atomic<long long> m_misses;
+
+    Shard& shardFor(uint64_t key);
+};
+
+#endif // ROUTE_CACHE_INCLUDED
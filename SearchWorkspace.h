@@ -0,0 +1,214 @@
+#ifndef SEARCH_WORKSPACE_INCLUDED
+#define SEARCH_WORKSPACE_INCLUDED
+
+#include "provided.h"
+#include <vector>
+#include <algorithm>
+// SearchWorkspace.h
+
+// Indexed 4-ary min-heap of node ids. Every node is in the heap at most once,
+// and decreasing the key of a queued node moves it up in place, so searches
+// never push duplicates or leave stale entries behind.
+class NodeHeap
+{
+public:
+    void resize(int numNodes)
+    {
+        if((int)m_position.size() < numNodes){
+            m_position.resize(numNodes, NOT_QUEUED);
+        }
+    }
+
+      // empties the heap; only the queued nodes are touched
+    void clear()
+    {
+        for(size_t i = 0; i < m_heap.size(); i++){
+            m_position[m_heap[i].node] = NOT_QUEUED;
+        }
+        m_heap.clear();
+    }
+
+    bool empty() const { return m_heap.empty(); }
+    int size() const { return m_heap.size(); }
+    bool contains(NodeID n) const { return m_position[n] != NOT_QUEUED; }
+    double minKey() const { return m_heap[0].key; }
+    NodeID minNode() const { return m_heap[0].node; }
+
+      // queues n with the given key, or lowers its key if it is queued with a larger one
+    void pushOrDecrease(NodeID n, double key)
+    {
+        int i = m_position[n];
+        if(i == NOT_QUEUED){
+            i = m_heap.size();
+            m_heap.push_back(Entry{key, n});
+        }
+        else if(key < m_heap[i].key){
+            m_heap[i].key = key;
+        }
+        else{
+            return;
+        }
+        siftUp(i);
+    }
+
+    NodeID popMin()
+    {
+        NodeID n = m_heap[0].node;
+        m_position[n] = NOT_QUEUED;
+        Entry last = m_heap.back();
+        m_heap.pop_back();
+        if(!m_heap.empty()){
+            m_heap[0] = last;
+            m_position[last.node] = 0;
+            siftDown(0);
+        }
+        return n;
+    }
+
+private:
+    struct Entry{
+        double key;
+        NodeID node;
+    };
+
+    static constexpr int NOT_QUEUED = -1;
+    static constexpr int ARITY = 4;
+
+    std::vector<Entry> m_heap;
+    std::vector<int> m_position;    // index in m_heap, per node
+
+    void siftUp(int i)
+    {
+        Entry e = m_heap[i];
+        while(i > 0){
+            int parent = (i - 1) / ARITY;
+            if(!(e.key < m_heap[parent].key)){
+                break;
+            }
+            m_heap[i] = m_heap[parent];
+            m_position[m_heap[i].node] = i;
+            i = parent;
+        }
+        m_heap[i] = e;
+        m_position[e.node] = i;
+    }
+
+    void siftDown(int i)
+    {
+        Entry e = m_heap[i];
+        int n = m_heap.size();
+        for(;;){
+            int first = i * ARITY + 1;
+            if(first >= n){
+                break;
+            }
+            int best = first;
+            int last = first + ARITY < n ? first + ARITY : n;
+            for(int c = first + 1; c < last; c++){
+                if(m_heap[c].key < m_heap[best].key){
+                    best = c;
+                }
+            }
+            if(!(m_heap[best].key < e.key)){
+                break;
+            }
+            m_heap[i] = m_heap[best];
+            m_position[m_heap[i].node] = i;
+            i = best;
+        }
+        m_heap[i] = e;
+        m_position[e.node] = i;
+    }
+};
+
+// Per-node search state for one graph search: tentative distance, parent
+// edge, a cached heuristic value and a settled flag, plus the queue. All of it
+// is stored in flat arrays indexed by NodeID. Instead of clearing the arrays
+// between searches, every entry carries the generation that wrote it and
+// start() just bumps the current generation, so once the arrays have grown to
+// the size of the map a search allocates nothing.
+class SearchWorkspace
+{
+public:
+    SearchWorkspace()
+     : m_generation(0), m_numSettled(0)
+    {}
+
+      // begins a new search over a graph with numNodes nodes
+    void start(int numNodes)
+    {
+        if((int)m_reached.size() < numNodes){
+            m_distance.resize(numNodes);
+            m_parent.resize(numNodes);
+            m_heuristic.resize(numNodes);
+            m_reached.resize(numNodes, 0);
+            m_settled.resize(numNodes, 0);
+            m_estimated.resize(numNodes, 0);
+        }
+        heap.resize(numNodes);
+        heap.clear();
+        m_numSettled = 0;
+
+        m_generation++;
+        if(m_generation == 0){ //the stamps wrapped around, so old ones could look current
+            std::fill(m_reached.begin(), m_reached.end(), 0);
+            std::fill(m_settled.begin(), m_settled.end(), 0);
+            std::fill(m_estimated.begin(), m_estimated.end(), 0);
+            m_generation = 1;
+        }
+    }
+
+    bool reached(NodeID n) const { return m_reached[n] == m_generation; }
+    bool settled(NodeID n) const { return m_settled[n] == m_generation; }
+    double distance(NodeID n) const { return m_distance[n]; }
+    EdgeID parent(NodeID n) const { return m_parent[n]; }
+
+      // records a tentative distance; the caller checks that it improves on the old one
+    void reach(NodeID n, double distance, EdgeID parent)
+    {
+        m_reached[n] = m_generation;
+        m_distance[n] = distance;
+        m_parent[n] = parent;
+    }
+
+    void settle(NodeID n)
+    {
+        m_settled[n] = m_generation;
+        m_numSettled++;
+    }
+
+      // nodes settled since start()
+    int numSettled() const { return m_numSettled; }
+
+      // heuristic values are computed once per node per search
+    bool hasHeuristic(NodeID n) const { return m_estimated[n] == m_generation; }
+    double heuristic(NodeID n) const { return m_heuristic[n]; }
+    void setHeuristic(NodeID n, double h)
+    {
+        m_estimated[n] = m_generation;
+        m_heuristic[n] = h;
+    }
+
+    NodeHeap heap;
+
+private:
+    unsigned int m_generation;
+    int m_numSettled;
+    std::vector<double> m_distance;
+    std::vector<EdgeID> m_parent;
+    std::vector<double> m_heuristic;
+    std::vector<unsigned int> m_reached;    // generation stamps
+    std::vector<unsigned int> m_settled;
+    std::vector<unsigned int> m_estimated;
+};
+
+  // The calling thread's workspaces. Searches that run two at once (forward and
+  // backward) use both; keeping them per thread makes the routers thread-safe
+  // and lets a warm thread route without allocating.
+inline SearchWorkspace& threadWorkspace(int which = 0)
+{
+    thread_local SearchWorkspace ws[2];
+    return ws[which];
+}
+
+#endif // SEARCH_WORKSPACE_INCLUDED
@@ -0,0 +1,216 @@
+#include "SpatialIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+using namespace std;
+
+SpatialIndex::SpatialIndex()
+ : m_graph(nullptr), m_minLatitude(0), m_minLongitude(0), m_longitudeScale(1), m_cellSize(1), m_columns(0), m_rows(0)
+{
+}
+
+void SpatialIndex::build(const StreetGraph& graph)
+{
+    m_graph = &graph;
+    m_nodes.clear();
+    m_segments.clear();
+    m_columns = 0;
+    m_rows = 0;
+    int numNodes = graph.numNodes();
+    if(numNodes == 0){
+        m_nodeOffsets.assign(1, 0);
+        m_segmentOffsets.assign(1, 0);
+        return;
+    }
+
+    double maxLatitude = -numeric_limits<double>::infinity();
+    double maxLongitude = -numeric_limits<double>::infinity();
+    m_minLatitude = numeric_limits<double>::infinity();
+    m_minLongitude = numeric_limits<double>::infinity();
+    for(NodeID n = 0; n < numNodes; n++){
+        m_minLatitude = min(m_minLatitude, graph.latitude(n));
+        m_minLongitude = min(m_minLongitude, graph.longitude(n));
+        maxLatitude = max(maxLatitude, graph.latitude(n));
+        maxLongitude = max(maxLongitude, graph.longitude(n));
+    }
+    m_longitudeScale = cos(deg2rad((m_minLatitude + maxLatitude) / 2));
+
+    //square cells, about NODES_PER_CELL nodes each on average
+    double width = max(x(maxLongitude), 1e-9);
+    double height = max(y(maxLatitude), 1e-9);
+    double cells = max(1.0, double(numNodes) / NODES_PER_CELL);
+    m_cellSize = sqrt(width * height / cells);
+    m_cellSize = max(m_cellSize, max(width, height) / cells); //a map that is all one line still gets one cell per few nodes
+    m_columns = int(width / m_cellSize) + 1;
+    m_rows = int(height / m_cellSize) + 1;
+    int numCells = m_columns * m_rows;
+
+    //counting sort of the nodes by cell
+    vector<int> cellOf (numNodes);
+    m_nodeOffsets.assign(numCells + 1, 0);
+    for(NodeID n = 0; n < numNodes; n++){
+        cellOf[n] = row(y(graph.latitude(n))) * m_columns + column(x(graph.longitude(n)));
+        m_nodeOffsets[cellOf[n] + 1]++;
+    }
+    for(int c = 0; c < numCells; c++){
+        m_nodeOffsets[c + 1] += m_nodeOffsets[c];
+    }
+    m_nodes.resize(numNodes);
+    vector<int> fill (m_nodeOffsets.begin(), m_nodeOffsets.end() - 1);
+    for(NodeID n = 0; n < numNodes; n++){
+        m_nodes[fill[cellOf[n]]++] = n;
+    }
+
+    //segments by every cell their bounding box overlaps: count, then place
+    m_segmentOffsets.assign(numCells + 1, 0);
+    for(int pass = 0; pass < 2; pass++){
+        for(EdgeID e = 0; e < graph.numEdges(); e++){
+            if(graph.twin(e) < e){ //one direction is enough
+                continue;
+            }
+            NodeID a = graph.source(e);
+            NodeID b = graph.target(e);
+            int c0 = column(x(min(graph.longitude(a), graph.longitude(b))));
+            int c1 = column(x(max(graph.longitude(a), graph.longitude(b))));
+            int r0 = row(y(min(graph.latitude(a), graph.latitude(b))));
+            int r1 = row(y(max(graph.latitude(a), graph.latitude(b))));
+            for(int r = r0; r <= r1; r++){
+                for(int c = c0; c <= c1; c++){
+                    if(pass == 0){
+                        m_segmentOffsets[r * m_columns + c + 1]++;
+                    }
+                    else{
+                        m_segments[fill[r * m_columns + c]++] = e;
+                    }
+                }
+            }
+        }
+        if(pass == 0){
+            for(int c = 0; c < numCells; c++){
+                m_segmentOffsets[c + 1] += m_segmentOffsets[c];
+            }
+            m_segments.resize(m_segmentOffsets[numCells]);
+            fill.assign(m_segmentOffsets.begin(), m_segmentOffsets.end() - 1);
+        }
+    }
+}
+
+int SpatialIndex::column(double px) const
+{
+    return min(m_columns - 1, max(0, int(floor(px / m_cellSize))));
+}
+
+int SpatialIndex::row(double py) const
+{
+    return min(m_rows - 1, max(0, int(floor(py / m_cellSize))));
+}
+
+template<typename Visit>
+void SpatialIndex::search(double px, double py, const double& best, Visit visit) const
+{
+    //the point's own cell, which may lie outside the grid
+    long long cx = (long long)floor(px / m_cellSize);
+    long long cy = (long long)floor(py / m_cellSize);
+    long long dx = cx < 0 ? -cx : max(0LL, cx - (m_columns - 1));
+    long long dy = cy < 0 ? -cy : max(0LL, cy - (m_rows - 1));
+    long long first = max(dx, dy); //nearest ring that reaches the grid
+    long long last = max(max(cx, m_columns - 1 - cx), max(cy, m_rows - 1 - cy));
+
+    //everything in ring r is more than r - 1 cells away from the point; best is a squared distance
+    for(long long r = first; r <= last && (r <= 1 || (r - 1) * (r - 1) * m_cellSize * m_cellSize <= best); r++){
+        long long top = max(0LL, cy - r);
+        long long bottom = min((long long)m_rows - 1, cy + r);
+        for(long long gy = top; gy <= bottom; gy++){
+            if(gy == cy - r || gy == cy + r){ //a whole row of the ring
+                long long left = max(0LL, cx - r);
+                long long right = min((long long)m_columns - 1, cx + r);
+                for(long long gx = left; gx <= right; gx++){
+                    visit(int(gy * m_columns + gx));
+                }
+            }
+            else{ //just its two sides
+                if(cx - r >= 0 && cx - r < m_columns){
+                    visit(int(gy * m_columns + cx - r));
+                }
+                if(r > 0 && cx + r >= 0 && cx + r < m_columns){
+                    visit(int(gy * m_columns + cx + r));
+                }
+            }
+        }
+    }
+}
+
+NodeID SpatialIndex::nearestNode(double latitude, double longitude) const
+{
+    NodeID nearest = NO_NODE;
+    if(m_nodes.empty()){
+        return nearest;
+    }
+    double px = x(longitude);
+    double py = y(latitude);
+    double best = numeric_limits<double>::infinity();
+    search(px, py, best, [&](int cell){
+        for(int i = m_nodeOffsets[cell]; i < m_nodeOffsets[cell + 1]; i++){
+            NodeID n = m_nodes[i];
+            double dx = x(m_graph->longitude(n)) - px;
+            double dy = y(m_graph->latitude(n)) - py;
+            double d = dx * dx + dy * dy;
+            if(d < best || (d == best && n < nearest)){
+                best = d;
+                nearest = n;
+            }
+        }
+    });
+    return nearest;
+}
+
+NodeID SpatialIndex::nearestNode(double latitude, double longitude, double maxKM) const
+{
+    NodeID n = nearestNode(latitude, longitude);
+    if(n == NO_NODE || crowDistanceKM(unitVector(latitude, longitude), m_graph->points().point(n)) > maxKM){
+        return NO_NODE;
+    }
+    return n;
+}
+
+EdgeID SpatialIndex::nearestSegment(double latitude, double longitude, double& fraction) const
+{
+    EdgeID nearest = NO_EDGE;
+    fraction = 0;
+    if(m_segments.empty()){
+        return nearest;
+    }
+    double px = x(longitude);
+    double py = y(latitude);
+    double best = numeric_limits<double>::infinity();
+    search(px, py, best, [&](int cell){
+        for(int i = m_segmentOffsets[cell]; i < m_segmentOffsets[cell + 1]; i++){
+            EdgeID e = m_segments[i];
+            double t;
+            double d = segmentDistance(e, px, py, t);
+            if(d < best || (d == best && e < nearest)){
+                best = d;
+                nearest = e;
+                fraction = t;
+            }
+        }
+    });
+    return nearest;
+}
+
+  //squared distance from (px, py) to segment e on the plane, and how far along e the nearest point is
+double SpatialIndex::segmentDistance(EdgeID e, double px, double py, double& fraction) const
+{
+    NodeID a = m_graph->source(e);
+    NodeID b = m_graph->target(e);
+    double ax = x(m_graph->longitude(a));
+    double ay = y(m_graph->latitude(a));
+    double ux = x(m_graph->longitude(b)) - ax;
+    double uy = y(m_graph->latitude(b)) - ay;
+    double lengthSquared = ux * ux + uy * uy;
+    fraction = lengthSquared > 0 ? ((px - ax) * ux + (py - ay) * uy) / lengthSquared : 0;
+    fraction = min(1.0, max(0.0, fraction));
+    double dx = ax + fraction * ux - px;
+    double dy = ay + fraction * uy - py;
+    return dx * dx + dy * dy;
+}
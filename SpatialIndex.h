@@ -0,0 +1,63 @@
+#ifndef SPATIAL_INDEX_INCLUDED
+#define SPATIAL_INDEX_INCLUDED
+
+#include "StreetGraph.h"
+#include <vector>
+// SpatialIndex.h
+
+// Uniform grid over a StreetGraph's nodes and segments, built when a map is
+// loaded, for snapping coordinates that are not map vertices.
+//
+// Coordinates are projected onto a plane tangent at the middle of the map
+// (longitude scaled by the cosine of the middle latitude), which is accurate to
+// well under a meter over a city. The grid has about one cell per
+// NODES_PER_CELL nodes; every node is listed in its cell, and every segment
+// (once, not per direction) in each cell its bounding box overlaps. A query
+// visits rings of cells around its own, nearest first, and stops as soon as
+// the next ring can't hold anything closer than the best found so far.
+class SpatialIndex
+{
+public:
+    SpatialIndex();
+
+    void build(const StreetGraph& graph);
+
+      // nearest node to the point, NO_NODE if there are none
+    NodeID nearestNode(double latitude, double longitude) const;
+
+      // the same, but NO_NODE unless it is within maxKM
+    NodeID nearestNode(double latitude, double longitude, double maxKM) const;
+
+      // nearest segment to the point, NO_EDGE if there are none; fraction is
+      // where the nearest point lies along it, from source (0) to target (1)
+    EdgeID nearestSegment(double latitude, double longitude, double& fraction) const;
+
+private:
+    static constexpr int NODES_PER_CELL = 1;
+
+    const StreetGraph* m_graph;
+    double m_minLatitude;
+    double m_minLongitude;
+    double m_longitudeScale;            // cosine of the middle latitude
+    double m_cellSize;                  // in degrees of latitude
+    int m_columns;
+    int m_rows;
+    std::vector<int> m_nodeOffsets;     // nodes of cell c: m_nodes[m_nodeOffsets[c] ... m_nodeOffsets[c+1])
+    std::vector<NodeID> m_nodes;
+    std::vector<int> m_segmentOffsets;  // likewise for segments
+    std::vector<EdgeID> m_segments;
+
+    double x(double longitude) const { return (longitude - m_minLongitude) * m_longitudeScale; }
+    double y(double latitude) const { return latitude - m_minLatitude; }
+    int column(double px) const;
+    int row(double py) const;
+    double segmentDistance(EdgeID e, double px, double py, double& fraction) const;
+
+      // calls visit(cell) for the grid's cells in rings around (px, py),
+      // nearest ring first, until no cell left can hold anything nearer than
+      // the squared distance best, which visit lowers as it finds things
+    template<typename Visit>
+    void search(double px, double py, const double& best, Visit visit) const;
+};
+
+#endif // SPATIAL_INDEX_INCLUDED
@@ -0,0 +1,54 @@
+#include "SpeedProfiles.h"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+namespace {
+
+const double KM_PER_MILE = 1.609344;
+
+  //miles per hour to kilometers per minute
+double kmPerMinute(double mph)
+{
+    return mph * KM_PER_MILE / 60;
+}
+
+}
+
+SpeedProfiles::SpeedProfiles()
+{
+    reset(0);
+}
+
+void SpeedProfiles::reset(int numEdges)
+{
+    m_offsets.assign(1, 0);
+    m_minutes.clear();
+    m_speeds.clear();
+    m_maxSpeed = 0;
+    add(vector<SpeedPoint>(1, SpeedPoint(0, DEFAULT_SPEED_MPH)));
+    m_edgeProfiles.assign(numEdges, 0);
+}
+
+int SpeedProfiles::add(const vector<SpeedPoint>& points)
+{
+    if(points.empty() || numProfiles() > 0xFFFF){
+        return -1;
+    }
+    for(size_t i = 0; i < points.size(); i++){
+        bool inDay = points[i].minute >= 0 && points[i].minute < MINUTES_PER_DAY;
+        bool increasing = i == 0 || points[i].minute > points[i - 1].minute;
+        if(!inDay || !increasing || !(points[i].mph > 0) || !isfinite(points[i].mph)){
+            return -1;
+        }
+    }
+
+    for(size_t i = 0; i < points.size(); i++){
+        m_minutes.push_back(points[i].minute);
+        m_speeds.push_back(kmPerMinute(points[i].mph));
+        m_maxSpeed = max(m_maxSpeed, m_speeds.back());
+    }
+    m_offsets.push_back(m_minutes.size());
+    return numProfiles() - 1;
+}
@@ -0,0 +1,103 @@
+#ifndef SPEED_PROFILES_INCLUDED
+#define SPEED_PROFILES_INCLUDED
+
+#include "provided.h"
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+// SpeedProfiles.h
+
+// Time-of-day speeds for travel-time routing (PointToPointRouter's
+// generateTimedRoute). A profile is a piecewise-linear function from the time
+// of day to a speed, given by its breakpoints and repeating every day. Each
+// profile is stored once and shared by id; every edge refers to one by a
+// 16-bit id, profile 0 (a constant DEFAULT_SPEED_MPH) until told otherwise.
+//
+// An edge's travel time comes from driving its weight (StreetGraph::weight) at
+// the profile's speed as that changes on the way, integrated piece by piece,
+// rather than at the speed of the moment it is entered. So leaving later never
+// means arriving earlier (the FIFO property that keeps time-dependent A*
+// exact), and no edge takes less than its weight at maxSpeed(), the fastest
+// any profile goes, which is what the A* heuristic divides by.
+//
+// Times are minutes after midnight of the first day and may run past it;
+// speeds are kept in kilometers per minute.
+class SpeedProfiles
+{
+public:
+    static constexpr double DEFAULT_SPEED_MPH = 25;
+    static constexpr double MINUTES_PER_DAY = 24 * 60;
+
+    SpeedProfiles();
+
+      // every edge back on profile 0, and only profile 0 left
+    void reset(int numEdges);
+
+      // a new profile's id, or -1 if the breakpoints aren't strictly
+      // increasing minutes in [0, MINUTES_PER_DAY) with positive speeds, or
+      // there are already 65536 profiles
+    int add(const std::vector<SpeedPoint>& points);
+
+    int numProfiles() const { return m_offsets.size() - 1; }
+    int profile(EdgeID e) const { return m_edgeProfiles[e]; }
+    void setProfile(EdgeID e, int profile) { m_edgeProfiles[e] = profile; }
+
+      // kilometers per minute
+    double maxSpeed() const { return m_maxSpeed; }
+
+      // when driving km along edge e, starting at departure, ends
+    double arrival(EdgeID e, double km, double departure) const
+    {
+        int first = m_offsets[m_edgeProfiles[e]];
+        int last = m_offsets[m_edgeProfiles[e] + 1];
+        if(last - first == 1){
+            return departure + km / m_speeds[first];
+        }
+
+        //the piece i holding the time of day t: from breakpoint i to the next, the last one wrapping past midnight
+        double day = std::floor(departure / MINUTES_PER_DAY) * MINUTES_PER_DAY;
+        double t = departure - day;
+        int i = last - 1;
+        while(i > first && m_minutes[i] > t){
+            i--;
+        }
+        if(m_minutes[i] > t){ //before the first breakpoint, so in the previous day's last piece
+            i = last - 1;
+            t += MINUTES_PER_DAY;
+            day -= MINUTES_PER_DAY;
+        }
+
+        for(;;){
+            bool wraps = i + 1 == last;
+            double t0 = m_minutes[i];
+            double t1 = wraps ? m_minutes[first] + MINUTES_PER_DAY : m_minutes[i + 1];
+            double v1 = wraps ? m_speeds[first] : m_speeds[i + 1];
+            double slope = (v1 - m_speeds[i]) / (t1 - t0);
+            double v = m_speeds[i] + slope * (t - t0);
+            double span = t1 - t;
+            double reach = (v + slope * span / 2) * span; //distance covered by the end of the piece
+            if(reach >= km){
+                //solve v dt + slope dt^2 / 2 = km, in the form that stays accurate as slope goes to 0
+                return day + t + 2 * km / (v + std::sqrt(std::max(0.0, v * v + 2 * slope * km)));
+            }
+            km -= reach;
+            t = t1;
+            i++;
+            if(wraps){
+                i = first;
+                t -= MINUTES_PER_DAY;
+                day += MINUTES_PER_DAY;
+            }
+        }
+    }
+
+private:
+    std::vector<int> m_offsets;             // breakpoints of profile p: [m_offsets[p], m_offsets[p+1])
+    std::vector<double> m_minutes;
+    std::vector<double> m_speeds;           // kilometers per minute
+    std::vector<uint16_t> m_edgeProfiles;   // per edge
+    double m_maxSpeed;
+};
+
+#endif // SPEED_PROFILES_INCLUDED
@@ -0,0 +1,164 @@
+#include "provided.h"
+#include "Statistics.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+using namespace std;
+
+namespace {
+
+const char* const COUNTER_NAMES[NUM_STAT_COUNTERS] = {
+    "nodes settled", "heap pushes", "heap pops", "heap decreases",
+    "hash probes", "hash resizes", "optimizer iterations", "optimizer acceptances"
+};
+
+const char* const TIMER_NAMES[NUM_STAT_TIMERS] = { "route", "optimize", "plan" };
+
+}
+
+StatisticsImpl::StatisticsImpl()
+{
+    clear();
+}
+
+void StatisticsImpl::add(const Counting& counting)
+{
+    for(int c = 0; c < NUM_STAT_COUNTERS; c++){
+        if(counting.counts[c] != 0){
+            m_counters[c].fetch_add(counting.counts[c], memory_order_relaxed);
+        }
+    }
+}
+
+void StatisticsImpl::record(StatTimer t, Clock::duration elapsed)
+{
+    long long ns = chrono::duration_cast<chrono::nanoseconds>(elapsed).count();
+    int b = 0;
+    for(long long us = ns / 1000; us > 0 && b < NUM_BUCKETS - 1; us >>= 1){ //bit length of the whole microseconds
+        b++;
+    }
+    m_buckets[t][b].fetch_add(1, memory_order_relaxed);
+    m_samples[t].fetch_add(1, memory_order_relaxed);
+    m_nanoseconds[t].fetch_add(ns, memory_order_relaxed);
+}
+
+double StatisticsImpl::bucketSeconds(int b)
+{
+    return ldexp(1e-6, b); //the upper bound of bucket b: 2^b microseconds
+}
+
+double StatisticsImpl::meanSeconds(StatTimer t) const
+{
+    long long n = samples(t);
+    return n > 0 ? m_nanoseconds[t].load(memory_order_relaxed) * 1e-9 / n : 0;
+}
+
+double StatisticsImpl::percentileSeconds(StatTimer t, double p) const
+{
+    long long counts[NUM_BUCKETS];
+    long long n = 0;
+    for(int b = 0; b < NUM_BUCKETS; b++){ //the counts as of now, since other threads may still be adding
+        counts[b] = m_buckets[t][b].load(memory_order_relaxed);
+        n += counts[b];
+    }
+    if(n == 0){
+        return 0;
+    }
+    long long rank = max(1LL, (long long)ceil(p * n));
+    long long seen = 0;
+    for(int b = 0; b < NUM_BUCKETS; b++){
+        seen += counts[b];
+        if(seen >= rank){
+            return bucketSeconds(b);
+        }
+    }
+    return bucketSeconds(NUM_BUCKETS - 1);
+}
+
+void StatisticsImpl::clear()
+{
+    for(int c = 0; c < NUM_STAT_COUNTERS; c++){
+        m_counters[c].store(0, memory_order_relaxed);
+    }
+    for(int t = 0; t < NUM_STAT_TIMERS; t++){
+        m_samples[t].store(0, memory_order_relaxed);
+        m_nanoseconds[t].store(0, memory_order_relaxed);
+        for(int b = 0; b < NUM_BUCKETS; b++){
+            m_buckets[t][b].store(0, memory_order_relaxed);
+        }
+    }
+}
+
+void StatisticsImpl::dump(ostream& out) const
+{
+    for(int c = 0; c < NUM_STAT_COUNTERS; c++){
+        out << COUNTER_NAMES[c] << ": " << counter(StatCounter(c)) << endl;
+    }
+
+    ios::fmtflags flags = out.flags();
+    streamsize precision = out.precision();
+    out << fixed << setprecision(3);
+    for(int t = 0; t < NUM_STAT_TIMERS; t++){
+        StatTimer timer = StatTimer(t);
+        if(samples(timer) == 0){
+            continue;
+        }
+        out << TIMER_NAMES[t] << " latency: " << samples(timer) << " calls, mean " << meanSeconds(timer) * 1000
+            << " ms, p50 <= " << percentileSeconds(timer, 0.5) * 1000 << " ms, p95 <= " << percentileSeconds(timer, 0.95) * 1000
+            << " ms, p99 <= " << percentileSeconds(timer, 0.99) * 1000 << " ms" << endl;
+        for(int b = 0; b < NUM_BUCKETS; b++){
+            long long n = m_buckets[t][b].load(memory_order_relaxed);
+            if(n != 0){
+                out << "  < " << bucketSeconds(b) * 1000 << " ms: " << n << endl;
+            }
+        }
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+//******************** Statistics functions ***********************************
+
+// These functions simply delegate to StatisticsImpl's functions.
+
+Statistics::Statistics()
+{
+    m_impl = new StatisticsImpl;
+}
+
+Statistics::~Statistics()
+{
+    delete m_impl;
+}
+
+long long Statistics::counter(StatCounter c) const
+{
+    return m_impl->counter(c);
+}
+
+long long Statistics::samples(StatTimer t) const
+{
+    return m_impl->samples(t);
+}
+
+double Statistics::meanSeconds(StatTimer t) const
+{
+    return m_impl->meanSeconds(t);
+}
+
+double Statistics::percentileSeconds(StatTimer t, double p) const
+{
+    return m_impl->percentileSeconds(t, p);
+}
+
+void Statistics::clear()
+{
+    m_impl->clear();
+}
+
+void Statistics::dump(ostream& out) const
+{
+    m_impl->dump(out);
+}
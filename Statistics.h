@@ -0,0 +1,110 @@
+#ifndef STATISTICS_INCLUDED
+#define STATISTICS_INCLUDED
+
+#include "provided.h"
+#include <atomic>
+#include <chrono>
+// Statistics.h
+
+// Implementation of the public Statistics, and the counting policies that the
+// searches, the coordinate index, the route cache and the annealer take as a
+// template parameter.
+//
+// With NoCounting every hook is an empty inline function, so that
+// instantiation compiles to the code there was before the hooks; with
+// Counting they add to plain per-query totals. Routers and optimizers only
+// pick the counting version when they have a Statistics, and then add a
+// query's totals to it at the end with relaxed atomic adds, so queries on
+// several threads share one without locking.
+//
+// Latencies go into histograms of power-of-two buckets: bucket 0 holds calls
+// under 1 microsecond, bucket b > 0 those from 2^(b-1) up to 2^b microseconds.
+struct NoCounting
+{
+    void pop() {}
+    void settle() {}
+    void push(bool) {}
+    void probe() {}
+    void resize() {}
+    void iterate() {}
+    void accept() {}
+    void add(const NoCounting&) {}
+};
+
+struct Counting
+{
+    long long counts[NUM_STAT_COUNTERS] = {};
+
+    void pop() { counts[STAT_HEAP_POPS]++; }
+    void settle() { counts[STAT_NODES_SETTLED]++; }
+      // a node queued, or its key lowered if it already was
+    void push(bool queued) { counts[queued ? STAT_HEAP_DECREASES : STAT_HEAP_PUSHES]++; }
+    void probe() { counts[STAT_HASH_PROBES]++; }
+    void resize() { counts[STAT_HASH_RESIZES]++; }
+    void iterate() { counts[STAT_OPTIMIZER_ITERATIONS]++; }
+    void accept() { counts[STAT_OPTIMIZER_ACCEPTANCES]++; }
+    void add(const Counting& other)
+    {
+        for(int c = 0; c < NUM_STAT_COUNTERS; c++){
+            counts[c] += other.counts[c];
+        }
+    }
+};
+
+class StatisticsImpl
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    StatisticsImpl();
+    void add(const Counting& counting);
+    void add(const NoCounting&) {}
+    void record(StatTimer t, Clock::duration elapsed);
+    long long counter(StatCounter c) const { return m_counters[c].load(std::memory_order_relaxed); }
+    long long samples(StatTimer t) const { return m_samples[t].load(std::memory_order_relaxed); }
+    double meanSeconds(StatTimer t) const;
+    double percentileSeconds(StatTimer t, double p) const;
+    void clear();
+    void dump(std::ostream& out) const;
+
+private:
+    static constexpr int NUM_BUCKETS = 40;  // up to 2^39 microseconds, about six days
+
+    std::atomic<long long> m_counters[NUM_STAT_COUNTERS];
+    std::atomic<long long> m_samples[NUM_STAT_TIMERS];
+    std::atomic<long long> m_nanoseconds[NUM_STAT_TIMERS];  // totals, for the means
+    std::atomic<long long> m_buckets[NUM_STAT_TIMERS][NUM_BUCKETS];
+
+    static double bucketSeconds(int b);
+};
+
+  // Times its scope into stats' timer t, or does nothing (not even read the
+  // clock) when stats is nullptr.
+class ScopedLatency
+{
+public:
+    ScopedLatency(StatisticsImpl* stats, StatTimer t)
+     : m_stats(stats), m_timer(t)
+    {
+        if(m_stats != nullptr){
+            m_began = StatisticsImpl::Clock::now();
+        }
+    }
+
+    ~ScopedLatency()
+    {
+        if(m_stats != nullptr){
+            m_stats->record(m_timer, StatisticsImpl::Clock::now() - m_began);
+        }
+    }
+
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+    StatisticsImpl* m_stats;
+    StatTimer m_timer;
+    StatisticsImpl::Clock::time_point m_began;
+};
+
+#endif // STATISTICS_INCLUDED
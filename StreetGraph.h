@@ -0,0 +1,160 @@
+#ifndef STREET_GRAPH_INCLUDED
+#define STREET_GRAPH_INCLUDED
+
+#include "provided.h"
+#include "MapImage.h"
+#include "CrowDistance.h"
+#include "GeoKey.h"
+#include "Statistics.h"
+#include <string>
+#include <cmath>
+// StreetGraph.h
+
+// NodeID and EdgeID are declared in provided.h.
+const int NO_NODE = -1;
+const int NO_EDGE = -1;
+
+  // node ids are already well spread; the hash maps mix them further
+inline unsigned int hasher(const NodeID& n)
+{
+    return n;
+}
+
+// Compressed sparse row (CSR) form of a loaded StreetMap. Every vertex gets a
+// NodeID in [0, numNodes()), and every directed segment (each segment in the
+// map file plus its reverse) gets an EdgeID. The edges leaving node n are the
+// contiguous range [edgeBegin(n), edgeEnd(n)), in the same order the map file
+// listed them. GeoCoord and StreetSegment are only built at the API boundary.
+//
+// The arrays are not owned: they point into the map image (MapImage.h) that
+// StreetMapImpl either built from a text map or mapped from a compiled file.
+class StreetGraph
+{
+public:
+    StreetGraph()
+     : m_numNodes(0), m_numEdges(0), m_indexMask(0), m_weights(nullptr), m_points(nullptr)
+    {}
+
+    int numNodes() const { return m_numNodes; }
+    int numEdges() const { return m_numEdges; }
+
+    EdgeID edgeBegin(NodeID n) const { return m_offsets[n]; }
+    EdgeID edgeEnd(NodeID n) const { return m_offsets[n+1]; }
+    EdgeRange edgesFrom(NodeID n) const { return EdgeRange(m_offsets[n], m_offsets[n+1]); }
+
+    NodeID source(EdgeID e) const { return m_sources[e]; }
+    NodeID target(EdgeID e) const { return m_targets[e]; }
+
+      // the same street segment traversed the other way; the map file lists
+      // every segment once and the loader adds both directions
+    EdgeID twin(EdgeID e) const { return m_twins[e]; }
+
+      // length of an edge in kilometers
+    double length(EdgeID e) const { return m_lengths[e]; }
+
+    double lengthMiles(EdgeID e) const
+    {
+        const double milesPerKm = 1 / 1.609344;
+        return m_lengths[e] * milesPerKm;
+    }
+
+      // what a search pays for the edge, in kilometers: its length, unless
+      // StreetMap::updateSegmentWeights slowed it down (never below the
+      // length) or closed it (infinity)
+    double weight(EdgeID e) const { return m_weights[e]; }
+
+      // node position in degrees
+    double latitude(NodeID n) const { return m_keys[n].latitudeDegrees(); }
+    double longitude(NodeID n) const { return m_keys[n].longitudeDegrees(); }
+    GeoKey key(NodeID n) const { return m_keys[n]; }
+
+    const char* streetName(EdgeID e) const { return m_nameText + m_nameOffsets[m_edgeNames[e]]; }
+
+      // street names are interned: edges on the same street share one id
+    int nameId(EdgeID e) const { return m_edgeNames[e]; }
+    const char* name(int nameId) const { return m_nameText + m_nameOffsets[nameId]; }
+
+      // great-circle distance between two nodes, as distanceEarthKM but without
+      // trigonometry (see CrowDistance.h)
+    double distanceKM(NodeID a, NodeID b) const { return crowDistanceKM(m_points->point(a), m_points->point(b)); }
+
+      // every node's unit vector, for the batch kernels in CrowDistance.h
+    const GeoPoints& points() const { return *m_points; }
+
+      // API boundary conversions
+    bool findNode(const GeoCoord& gc, NodeID& n) const
+    {
+        GeoKey key;
+        return makeGeoKey(gc.latitudeText, gc.longitudeText, key) && findNode(key, n);
+    }
+
+    bool findNode(const GeoKey& key, NodeID& n) const
+    {
+        NoCounting none;
+        return findNode(key, n, none);
+    }
+
+      // the same, calling counter.probe() for every key compared (see Statistics.h)
+    template<typename Counter>
+    bool findNode(const GeoCoord& gc, NodeID& n, Counter& counter) const
+    {
+        GeoKey key;
+        return makeGeoKey(gc.latitudeText, gc.longitudeText, key) && findNode(key, n, counter);
+    }
+
+    template<typename Counter>
+    bool findNode(const GeoKey& key, NodeID& n, Counter& counter) const
+    {
+        if(m_numNodes == 0){
+            return false;
+        }
+        uint32_t slot = hasher(key) & m_indexMask;
+        while(m_index[slot] != NO_NODE){ //linear probing, the table is at most half full
+            counter.probe();
+            if(m_keys[m_index[slot]] == key){
+                n = m_index[slot];
+                return true;
+            }
+            slot = (slot + 1) & m_indexMask;
+        }
+        return false;
+    }
+
+    GeoCoord coord(NodeID n) const
+    {
+        GeoKey key = m_keys[n];
+        char text[16]; //short enough for the strings to stay in place, without allocating
+        GeoCoord gc;
+        gc.latitudeText.assign(text, formatFixed7(key.latitude(), text));
+        gc.longitudeText.assign(text, formatFixed7(key.longitude(), text));
+        gc.latitude = key.latitudeDegrees();
+        gc.longitude = key.longitudeDegrees();
+        return gc;
+    }
+
+    StreetSegment segment(EdgeID e) const
+    {
+        return StreetSegment(coord(m_sources[e]), coord(m_targets[e]), streetName(e));
+    }
+
+private:
+    friend class StreetMapImpl;
+
+    int m_numNodes;
+    int m_numEdges;
+    uint32_t m_indexMask;
+    const GeoKey* m_keys;               // per node
+    const EdgeID* m_offsets;            // numNodes()+1 entries
+    const NodeID* m_sources;            // per edge
+    const NodeID* m_targets;            // per edge
+    const EdgeID* m_twins;              // per edge
+    const double* m_lengths;            // per edge, kilometers
+    const double* m_weights;            // per edge: m_lengths, or StreetMapImpl's copy with the weight changes
+    const int32_t* m_edgeNames;         // per edge, interned name id
+    const uint32_t* m_nameOffsets;
+    const char* m_nameText;
+    const NodeID* m_index;              // open addressed GeoKey -> node id
+    const GeoPoints* m_points;          // per node, computed when the image is attached
+};
+
+#endif // STREET_GRAPH_INCLUDED
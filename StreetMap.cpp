@@ -4,14 +4,86 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include <atomic>
 #include "ExpandableHashMap.h"
+#include "FlatHashMap.h"
+#include "StreetGraph.h"
+#include "MapImage.h"
+#include "ContractionHierarchy.h"
+#include "Landmarks.h"
+#include "SpatialIndex.h"
+#include "SpeedProfiles.h"
+#include "WorkerPool.h"
 #include <iostream>
 #include <fstream>
+#include <cstring>
+#include <cmath>
+#include <charconv>
+#include <algorithm>
+#include <climits>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 using namespace std;
 
+  //by the coordinate's fixed point key, so no string is built; equal text always means an equal key
 unsigned int hasher(const GeoCoord& g)
 {
-    return hash<string>()(g.latitudeText + g.longitudeText);
+    GeoKey key;
+    if(makeGeoKey(g.latitudeText, g.longitudeText, key)){
+        return hasher(key);
+    }
+    return hash<string>()(g.latitudeText) * 31 + hash<string>()(g.longitudeText);
+}
+
+  //by key as well, so equal coordinates always hash alike; text that isn't a plain decimal number only equals the same text
+bool operator==(const GeoCoord& lhs, const GeoCoord& rhs)
+{
+    if(lhs.latitudeText == rhs.latitudeText && lhs.longitudeText == rhs.longitudeText){
+        return true;
+    }
+    GeoKey a, b;
+    return makeGeoKey(lhs.latitudeText, lhs.longitudeText, a) && makeGeoKey(rhs.latitudeText, rhs.longitudeText, b) && a == b;
+}
+
+  //by latitude then longitude; text that isn't a plain decimal number sorts after all numbers, by text
+bool operator<(const GeoCoord& lhs, const GeoCoord& rhs)
+{
+    GeoKey a = {0}, b = {0};
+    bool lhsNumber = makeGeoKey(lhs.latitudeText, lhs.longitudeText, a);
+    bool rhsNumber = makeGeoKey(rhs.latitudeText, rhs.longitudeText, b);
+    if(lhsNumber && rhsNumber){
+        if(a.latitude() != b.latitude()){
+            return a.latitude() < b.latitude();
+        }
+        return a.longitude() < b.longitude();
+    }
+    if(lhsNumber != rhsNumber){
+        return lhsNumber;
+    }
+    if(lhs.latitudeText != rhs.latitudeText){
+        return lhs.latitudeText < rhs.latitudeText;
+    }
+    return lhs.longitudeText < rhs.longitudeText;
+}
+
+unsigned int hasher(const string& s)
+{
+    return hash<string>()(s);
+}
+
+namespace {
+
+  // versions are unique across all StreetMaps, so a RouteCache shared between maps can't mix them up
+unsigned int nextMapVersion()
+{
+    static atomic<unsigned int> counter(0);
+    return ++counter;
+}
+
 }
 
 class StreetMapImpl
@@ -20,86 +92,823 @@ public:
     StreetMapImpl();
     ~StreetMapImpl();
     bool load(string mapFile);
+    bool saveImage(string imageFile) const;
     bool getSegmentsThatStartWith(const GeoCoord& gc, vector<StreetSegment>& segs) const;
+    EdgeRange segmentsFrom(const GeoCoord& gc) const;
+    bool snapToNode(const GeoCoord& gc, GeoCoord& vertex) const;
+    bool snapToNodes(const vector<GeoCoord>& coords, vector<GeoCoord>& vertices) const;
+    bool snapToSegment(const GeoCoord& gc, StreetSegment& segment, GeoCoord& point) const;
+    const SpatialIndex& spatialIndex() const { return m_spatialIndex; }
+    const StreetGraph& graph() const { return m_graph; }
+    bool buildHierarchy();
+    const ContractionHierarchy* hierarchy() const { return m_hierarchy; }
+    bool buildLandmarks(int numLandmarks, LandmarkStrategy strategy);
+    const LandmarkTable* landmarks() const { return m_landmarks; }
+    unsigned int version() const { return m_version; }
+    bool updateSegmentWeights(const vector<SegmentWeightChange>& changes);
+    void resetSegmentWeights();
+    int addSpeedProfile(const vector<SpeedPoint>& points) { return m_speeds.add(points); }
+    bool setStreetSpeedProfile(const string& streetName, int profile);
+    bool setSegmentSpeedProfile(const GeoCoord& start, const GeoCoord& end, int profile, bool bothWays);
+    const SpeedProfiles& speedProfiles() const { return m_speeds; }
 private:
-    ExpandableHashMap<GeoCoord, vector<StreetSegment*> > map;
-    vector<StreetSegment> ss;
+    StreetGraph m_graph;
+    GeoPoints m_nodePoints;     //unit vectors of the nodes for crow distances, derived from the image
+    SpatialIndex m_spatialIndex;
+    unsigned int m_version;
+    vector<double> m_weights;   //per edge once a weight has been changed, until then the graph reads the lengths
+    SpeedProfiles m_speeds;
+    
+    //optional speedup data, built on request
+    ContractionHierarchy* m_hierarchy;
+    LandmarkTable* m_landmarks;
+    
+    //the map image that m_graph points into: either built from a text map, or a mapped compiled file
+    vector<uint64_t> m_buffer;
+    void* m_mapped;
+    size_t m_mappedSize;
+    const char* m_image;
+    size_t m_imageSize;
+    
+    bool loadText(string mapFile);
+    bool loadImage(string imageFile);
+    bool attach(const char* image, size_t size);
+    void release();
+    void reweigh(const vector<EdgeID>& changed);
 };
 
 StreetMapImpl::StreetMapImpl()
+ : m_version(0), m_hierarchy(nullptr), m_landmarks(nullptr), m_mapped(nullptr), m_mappedSize(0), m_image(nullptr), m_imageSize(0)
 {
     
 }
 
 StreetMapImpl::~StreetMapImpl()
 {
+    release();
+}
+
+void StreetMapImpl::release()
+{
+    delete m_hierarchy;
+    m_hierarchy = nullptr;
+    delete m_landmarks;
+    m_landmarks = nullptr;
+    m_graph = StreetGraph();
+    m_weights.clear();
+    m_weights.shrink_to_fit();
+    m_speeds.reset(0);
+    m_nodePoints.clear();
+    m_spatialIndex.build(m_graph);
+    m_buffer.clear();
+    m_buffer.shrink_to_fit();
+#ifndef _WIN32
+    if(m_mapped != nullptr){
+        munmap(m_mapped, m_mappedSize);
+    }
+#endif
+    m_mapped = nullptr;
+    m_mappedSize = 0;
+    m_image = nullptr;
+    m_imageSize = 0;
 }
 
 bool StreetMapImpl::load(string mapFile)
 {
-    ifstream infile(mapFile);
-   
+    //compiled images are recognized by their magic number, anything else is parsed as text
+    ifstream infile(mapFile, ios::binary);
     if(!infile){ return false;}
     
-    while(infile){
-        string name;
-        getline(infile, name);
+    char magic[sizeof(MAP_IMAGE_MAGIC)] = {};
+    infile.read(magic, sizeof(magic));
+    infile.close();
+    
+    release();
+    m_version = nextMapVersion();
+    if(memcmp(magic, MAP_IMAGE_MAGIC, sizeof(magic)) == 0){
+        return loadImage(mapFile);
+    }
+    return loadText(mapFile);
+}
+
+//******************** text maps ************************************
+
+namespace {
+
+struct ParsedMap
+{
+    vector<GeoKey> coords;
+    vector<string> names;
+    vector<NodeID> from, to; //directed edges in the order the file lists them
+    vector<int> edgeNames;
+    vector<double> lengths;  //kilometers
+};
+
+NodeID internCoord(ParsedMap& pm, FlatHashMap<GeoKey, NodeID>& ids, const GeoKey& gc)
+{
+    const NodeID* found = ids.find(gc);
+    if(found != nullptr){
+        return *found;
+    }
+    NodeID n = pm.coords.size(); //first time this vertex is seen, give it the next id
+    pm.coords.push_back(gc);
+    ids.associate(gc, n);
+    return n;
+}
+
+int internName(ParsedMap& pm, ExpandableHashMap<string, int>& ids, const string& name)
+{
+    const int* found = ids.find(name);
+    if(found != nullptr){
+        return *found;
+    }
+    int id = pm.names.size();
+    pm.names.push_back(name);
+    ids.associate(name, id);
+    return id;
+}
+
+  //just the numbers distanceEarthKM needs
+GeoCoord degrees(const GeoKey& key)
+{
+    GeoCoord gc;
+    gc.latitude = key.latitudeDegrees();
+    gc.longitude = key.longitudeDegrees();
+    return gc;
+}
+
+size_t align8(size_t n)
+{
+    return (n + 7) & ~size_t(7);
+}
+
+template<typename T>
+T* sectionData(char* image, const MapImageHeader& header, MapImageSection s)
+{
+    return reinterpret_cast<T*>(image + header.sectionOffset[s]);
+}
+
+//checks what the sections hold, in one pass over nodes and edges, so a corrupt image can't send a query outside them;
+//the section sizes have already been checked against the header
+bool validSections(char* image, const MapImageHeader& header)
+{
+    const int numNodes = header.numNodes;
+    const int numEdges = header.numEdges;
+    const EdgeID* offsets = sectionData<EdgeID>(image, header, SECTION_EDGE_OFFSETS);
+    const NodeID* sources = sectionData<NodeID>(image, header, SECTION_SOURCES);
+    const NodeID* targets = sectionData<NodeID>(image, header, SECTION_TARGETS);
+    const EdgeID* twins = sectionData<EdgeID>(image, header, SECTION_TWINS);
+    const double* lengths = sectionData<double>(image, header, SECTION_LENGTHS);
+    const int32_t* edgeNames = sectionData<int32_t>(image, header, SECTION_EDGE_NAMES);
+    const uint32_t* nameOffsets = sectionData<uint32_t>(image, header, SECTION_NAME_OFFSETS);
+    const char* nameText = sectionData<char>(image, header, SECTION_NAME_TEXT);
+    const NodeID* index = sectionData<NodeID>(image, header, SECTION_COORD_INDEX);
+    
+    if(offsets[0] != 0 || offsets[numNodes] != numEdges){
+        return false;
+    }
+    for(NodeID n = 0; n < numNodes; n++){
+        if(offsets[n + 1] < offsets[n]){
+            return false;
+        }
+        for(EdgeID e = offsets[n]; e < offsets[n + 1]; e++){
+            if(sources[e] != n || targets[e] < 0 || targets[e] >= numNodes || twins[e] < 0 || twins[e] >= numEdges
+               || !(lengths[e] >= 0) || edgeNames[e] < 0 || edgeNames[e] >= (int32_t)header.numNames){
+                return false;
+            }
+            //the hierarchy, the spatial index and the weight changes take a twin to be the same segment backwards
+            if(twins[twins[e]] != e || targets[twins[e]] != n){
+                return false;
+            }
+        }
+    }
+    
+    //every name has to end inside the text, which the last nul guarantees
+    uint64_t textSize = header.sectionSize[SECTION_NAME_TEXT];
+    if(header.numNames > 0 && (textSize == 0 || nameText[textSize - 1] != '\0')){
+        return false;
+    }
+    for(uint32_t i = 0; i < header.numNames; i++){
+        if(nameOffsets[i] >= textSize){
+            return false;
+        }
+    }
+    
+    //each node exactly once, which leaves the slots past numNodes empty so every probe for a missing key ends
+    vector<bool> indexed (numNodes, false);
+    int occupied = 0;
+    for(uint32_t slot = 0; slot < header.indexSlots; slot++){
+        NodeID n = index[slot];
+        if(n == NO_NODE){
+            continue;
+        }
+        if(n < 0 || n >= numNodes || indexed[n]){
+            return false;
+        }
+        indexed[n] = true;
+        occupied++;
+    }
+    return occupied == numNodes;
+}
 
-        if(name == ""){
+//lays the parsed map out as a map image (see MapImage.h)
+void buildImage(const ParsedMap& pm, vector<uint64_t>& buffer)
+{
+    MapImageHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAP_IMAGE_MAGIC, sizeof(header.magic));
+    header.version = MAP_IMAGE_VERSION;
+    header.byteOrder = MAP_IMAGE_BYTE_ORDER;
+    header.numNodes = pm.coords.size();
+    header.numEdges = pm.from.size();
+    header.numNames = pm.names.size();
+    header.indexSlots = 8;
+    while(header.indexSlots < 2 * header.numNodes){ //keep the coordinate index at most half full
+        header.indexSlots *= 2;
+    }
+    
+    size_t nameTextSize = 0;
+    for(size_t i = 0; i < pm.names.size(); i++){
+        nameTextSize += pm.names[i].size() + 1;
+    }
+    
+    uint64_t* sizes = header.sectionSize;
+    sizes[SECTION_COORD_KEYS] = header.numNodes * sizeof(GeoKey);
+    sizes[SECTION_EDGE_OFFSETS] = (header.numNodes + 1) * sizeof(EdgeID);
+    sizes[SECTION_SOURCES] = header.numEdges * sizeof(NodeID);
+    sizes[SECTION_TARGETS] = header.numEdges * sizeof(NodeID);
+    sizes[SECTION_TWINS] = header.numEdges * sizeof(EdgeID);
+    sizes[SECTION_LENGTHS] = header.numEdges * sizeof(double);
+    sizes[SECTION_EDGE_NAMES] = header.numEdges * sizeof(int32_t);
+    sizes[SECTION_NAME_OFFSETS] = header.numNames * sizeof(uint32_t);
+    sizes[SECTION_NAME_TEXT] = nameTextSize;
+    sizes[SECTION_COORD_INDEX] = header.indexSlots * sizeof(NodeID);
+    
+    size_t offset = align8(sizeof(MapImageHeader));
+    for(int s = 0; s < NUM_MAP_IMAGE_SECTIONS; s++){
+        header.sectionOffset[s] = offset;
+        offset = align8(offset + sizes[s]);
+    }
+    header.totalSize = offset;
+    
+    buffer.assign(offset / sizeof(uint64_t), 0);
+    char* image = reinterpret_cast<char*>(buffer.data());
+    memcpy(image, &header, sizeof(header));
+    
+    //nodes
+    GeoKey* keys = sectionData<GeoKey>(image, header, SECTION_COORD_KEYS);
+    NodeID* index = sectionData<NodeID>(image, header, SECTION_COORD_INDEX);
+    uint32_t mask = header.indexSlots - 1;
+    for(uint32_t s = 0; s < header.indexSlots; s++){
+        index[s] = NO_NODE;
+    }
+    for(NodeID n = 0; n < (NodeID)header.numNodes; n++){
+        keys[n] = pm.coords[n];
+        uint32_t slot = hasher(pm.coords[n]) & mask;
+        while(index[slot] != NO_NODE){
+            slot = (slot + 1) & mask;
+        }
+        index[slot] = n;
+    }
+    
+    //street names
+    uint32_t* nameOffsets = sectionData<uint32_t>(image, header, SECTION_NAME_OFFSETS);
+    char* nameText = sectionData<char>(image, header, SECTION_NAME_TEXT);
+    uint32_t textPos = 0;
+    for(size_t i = 0; i < pm.names.size(); i++){
+        nameOffsets[i] = textPos;
+        memcpy(nameText + textPos, pm.names[i].c_str(), pm.names[i].size() + 1);
+        textPos += pm.names[i].size() + 1;
+    }
+    
+    //edges: counting sort by start node; the sort is stable so every node keeps the file order of its edges
+    EdgeID* offsets = sectionData<EdgeID>(image, header, SECTION_EDGE_OFFSETS);
+    NodeID* sources = sectionData<NodeID>(image, header, SECTION_SOURCES);
+    NodeID* targets = sectionData<NodeID>(image, header, SECTION_TARGETS);
+    double* lengths = sectionData<double>(image, header, SECTION_LENGTHS);
+    int32_t* edgeNames = sectionData<int32_t>(image, header, SECTION_EDGE_NAMES);
+    int numNodes = header.numNodes;
+    int numEdges = header.numEdges;
+    for(int i = 0; i < numEdges; i++){
+        offsets[pm.from[i] + 1]++;
+    }
+    for(int n = 0; n < numNodes; n++){
+        offsets[n + 1] += offsets[n];
+    }
+    EdgeID* twins = sectionData<EdgeID>(image, header, SECTION_TWINS);
+    vector<EdgeID> next(offsets, offsets + numNodes);
+    vector<EdgeID> position(numEdges);
+    for(int i = 0; i < numEdges; i++){
+        EdgeID e = next[pm.from[i]]++;
+        position[i] = e;
+        sources[e] = pm.from[i];
+        targets[e] = pm.to[i];
+        lengths[e] = pm.lengths[i];
+        edgeNames[e] = pm.edgeNames[i];
+    }
+    for(int i = 0; i < numEdges; i++){ //the parser adds each segment and its reverse next to each other
+        twins[position[i]] = position[i ^ 1];
+    }
+}
+
+//A text map is a run of street records: a name line, a line with the number of segments, then that many
+//lines of "startLat startLon endLat endLon". The first blank name line, or the end of the file, ends the map.
+
+const size_t MIN_CHUNK_BYTES = 1 << 20; //smaller maps aren't worth splitting
+
+  //one run of whole records, parsed apart from the rest; coordinates and names get their ids when the runs are merged
+struct ParsedChunk
+{
+    vector<string> names;       //per record
+    vector<int> counts;         //per record
+    vector<GeoKey> ends;        //start and end of every segment
+    vector<double> lengths;     //per segment, kilometers
+    bool ok = true;
+};
+
+const char* endOfLine(const char* p, const char* end)
+{
+    const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+    return eol != nullptr ? eol : end;
+}
+
+bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+  //the segment count of the line [p, eol)
+bool parseCount(const char* p, const char* eol, int& count)
+{
+    while(p < eol && isBlank(*p)){
+        p++;
+    }
+    from_chars_result result = from_chars(p, eol, count);
+    return result.ec == errc() && count >= 0;
+}
+
+  //the record start offsets, found by reading only the name and count lines and skipping the segment lines,
+  //and end, the offset just past the last record
+bool findRecords(const char* text, size_t size, vector<size_t>& starts, size_t& end)
+{
+    const char* p = text;
+    const char* stop = text + size;
+    while(p < stop){
+        const char* eol = endOfLine(p, stop);
+        if(eol == p || (eol == p + 1 && *p == '\r')){ //blank name line
             break;
         }
-     
+        starts.push_back(p - text);
+        
+        p = eol + 1;
         int count;
-        infile >> count;
-        infile.ignore(1000, '\n');
+        if(p >= stop || !parseCount(p, eol = endOfLine(p, stop), count)){
+            return false;
+        }
+        p = eol + 1;
+        for(int i = 0; i < count; i++){
+            if(p >= stop){
+                return false;
+            }
+            p = endOfLine(p, stop) + 1;
+        }
+    }
+    end = min<size_t>(p - text, size);
+    return true;
+}
+
+  //the next whitespace separated number on the line, as a fixed point key component
+bool parseField(const char*& p, const char* eol, int32_t& value)
+{
+    while(p < eol && isBlank(*p)){
+        p++;
+    }
+    const char* begin = p;
+    while(p < eol && !isBlank(*p)){
+        p++;
+    }
+    return parseFixed7(begin, p - begin, value);
+}
+
+  //records [first, last), where records also holds the offset just past the final record
+void parseRecords(const char* text, const vector<size_t>& records, size_t first, size_t last, ParsedChunk& chunk)
+{
+    const char* stop = text + records[last];
+    for(size_t r = first; r < last; r++){
+        const char* p = text + records[r];
+        const char* eol = endOfLine(p, stop);
+        chunk.names.emplace_back(p, eol);
         
-        for(int i = 0; i < count; i++){ //for each line, associate the start geocoord to its streetsegment and the end geocoord to its reverse streetsegment
-            string startLat, startLong, endLat, endLong;
-            infile >> startLat >> startLong >> endLat >> endLong;
-            
-            infile.ignore(1000, '\n');
-            
-            GeoCoord B (startLat, startLong);
-            GeoCoord E (endLat, endLong);
-            
-            StreetSegment S (B, E, name);
-            StreetSegment reverseS (E, B, name);
-              
-            ss.push_back(S);
-            ss.push_back(reverseS);
+        int count;
+        p = eol + 1;
+        eol = endOfLine(p, stop);
+        parseCount(p, eol, count); //findRecords already checked it
+        chunk.counts.push_back(count);
+        
+        for(int i = 0; i < count; i++){
+            p = eol + 1;
+            eol = endOfLine(p, stop);
+            int32_t startLat, startLon, endLat, endLon;
+            if(!parseField(p, eol, startLat) || !parseField(p, eol, startLon) || !parseField(p, eol, endLat) || !parseField(p, eol, endLon)){
+                chunk.ok = false;
+                return;
+            }
+            GeoKey start = makeGeoKey(startLat, startLon);
+            GeoKey end = makeGeoKey(endLat, endLon);
+            chunk.ends.push_back(start);
+            chunk.ends.push_back(end);
+            chunk.lengths.push_back(distanceEarthKM(degrees(start), degrees(end)));
         }
     }
+}
+
+}
+
+bool StreetMapImpl::loadText(string mapFile)
+{
+    //the whole file in one read; the parsers work on the bytes in place
+    ifstream infile(mapFile, ios::binary | ios::ate);
+    if(!infile){ return false;}
+    size_t size = infile.tellg();
+    infile.seekg(0);
+    string text(size, '\0');
+    if(!infile.read(&text[0], size)){
+        return false;
+    }
+    infile.close();
     
-    for(int i = 0; i < ss.size(); i++){
-        vector<StreetSegment*>* vec = map.find(ss[i].start);
-        if(vec == nullptr){
-            vector<StreetSegment*> newVec;
-            newVec.push_back(&(ss[i]));
-            map.associate(ss[i].start, newVec);
+    vector<size_t> records;
+    size_t end;
+    if(!findRecords(text.data(), size, records, end)){
+        return false;
+    }
+    
+    //about equal byte ranges of whole records, a few per thread so a slow chunk doesn't hold up the rest
+    int numChunks = min<size_t>(4 * sharedWorkerPool().numThreads(), end / MIN_CHUNK_BYTES + 1);
+    vector<size_t> bounds(1, 0);
+    for(int c = 1; c < numChunks; c++){
+        size_t r = lower_bound(records.begin(), records.end(), end / numChunks * c) - records.begin();
+        if(r > bounds.back()){
+            bounds.push_back(r);
         }
-        else{
-            vec->push_back(&(ss[i]));
+    }
+    bounds.push_back(records.size());
+    records.push_back(end);
+    
+    numChunks = bounds.size() - 1;
+    vector<ParsedChunk> chunks(numChunks);
+    sharedWorkerPool().parallelFor(numChunks, [&](int c){
+        parseRecords(text.data(), records, bounds[c], bounds[c + 1], chunks[c]);
+    });
+    text = string();
+    
+    //interning in file order gives every node and name the same id a one pass parse would
+    ParsedMap pm;
+    FlatHashMap<GeoKey, NodeID> coordIds;
+    ExpandableHashMap<string, int> nameIds;
+    size_t numSegments = 0;
+    for(int c = 0; c < numChunks; c++){
+        if(!chunks[c].ok){
+            return false;
         }
+        numSegments += chunks[c].lengths.size();
+    }
+    coordIds.reserve(numSegments);
+    pm.from.reserve(2 * numSegments);
+    pm.to.reserve(2 * numSegments);
+    pm.edgeNames.reserve(2 * numSegments);
+    pm.lengths.reserve(2 * numSegments);
+    for(int c = 0; c < numChunks; c++){
+        const ParsedChunk& chunk = chunks[c];
+        size_t segment = 0;
+        for(size_t r = 0; r < chunk.names.size(); r++){
+            int nameId = internName(pm, nameIds, chunk.names[r]);
+            for(int i = 0; i < chunk.counts[r]; i++, segment++){ //add the segment and its reverse as directed edges
+                NodeID B = internCoord(pm, coordIds, chunk.ends[2 * segment]);
+                NodeID E = internCoord(pm, coordIds, chunk.ends[2 * segment + 1]);
+                double length = chunk.lengths[segment];
+                
+                pm.from.push_back(B); pm.to.push_back(E); pm.edgeNames.push_back(nameId); pm.lengths.push_back(length);
+                pm.from.push_back(E); pm.to.push_back(B); pm.edgeNames.push_back(nameId); pm.lengths.push_back(length);
+            }
+        }
+        chunks[c] = ParsedChunk(); //done with it
+    }
+    
+    buildImage(pm, m_buffer);
+    return attach(reinterpret_cast<const char*>(m_buffer.data()), m_buffer.size() * sizeof(uint64_t));
+}
+
+//******************** compiled map images ************************************
+
+bool StreetMapImpl::loadImage(string imageFile)
+{
+#ifdef _WIN32
+    //no mmap here, so read the whole image in one go
+    ifstream infile(imageFile, ios::binary | ios::ate);
+    if(!infile){ return false;}
+    size_t size = infile.tellg();
+    infile.seekg(0);
+    m_buffer.assign((size + 7) / 8, 0);
+    if(!infile.read(reinterpret_cast<char*>(m_buffer.data()), size)){
+        return false;
     }
+    return attach(reinterpret_cast<const char*>(m_buffer.data()), size);
+#else
+    int fd = open(imageFile.c_str(), O_RDONLY);
+    if(fd < 0){ return false;}
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0){
+        close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); //the mapping keeps the file alive
+    if(mapped == MAP_FAILED){ return false;}
     
-      
+    m_mapped = mapped;
+    m_mappedSize = st.st_size;
+    if(!attach(static_cast<const char*>(mapped), st.st_size)){
+        release();
+        return false;
+    }
     return true;
+#endif
 }
 
-bool StreetMapImpl::getSegmentsThatStartWith(const GeoCoord& gc, vector<StreetSegment>& segs) const
+//points m_graph at the sections of a map image, after checking that the header describes something that fits
+bool StreetMapImpl::attach(const char* image, size_t size)
+{
+    MapImageHeader header;
+    if(size < sizeof(header)){ return false;}
+    memcpy(&header, image, sizeof(header));
+    
+    if(memcmp(header.magic, MAP_IMAGE_MAGIC, sizeof(header.magic)) != 0 || header.version != MAP_IMAGE_VERSION || header.byteOrder != MAP_IMAGE_BYTE_ORDER){
+        return false;
+    }
+    if(header.totalSize > size || header.indexSlots == 0 || (header.indexSlots & (header.indexSlots - 1)) != 0 || header.indexSlots <= header.numNodes){
+        return false;
+    }
+    if(header.numNodes > INT_MAX - 1 || header.numEdges > INT_MAX){ //node and edge ids are ints
+        return false;
+    }
+    
+    uint64_t expected[NUM_MAP_IMAGE_SECTIONS];
+    expected[SECTION_COORD_KEYS] = header.numNodes * sizeof(GeoKey);
+    expected[SECTION_EDGE_OFFSETS] = (header.numNodes + 1) * sizeof(EdgeID);
+    expected[SECTION_SOURCES] = header.numEdges * sizeof(NodeID);
+    expected[SECTION_TARGETS] = header.numEdges * sizeof(NodeID);
+    expected[SECTION_TWINS] = header.numEdges * sizeof(EdgeID);
+    expected[SECTION_LENGTHS] = header.numEdges * sizeof(double);
+    expected[SECTION_EDGE_NAMES] = header.numEdges * sizeof(int32_t);
+    expected[SECTION_NAME_OFFSETS] = header.numNames * sizeof(uint32_t);
+    expected[SECTION_NAME_TEXT] = header.sectionSize[SECTION_NAME_TEXT];
+    expected[SECTION_COORD_INDEX] = header.indexSlots * sizeof(NodeID);
+    for(int s = 0; s < NUM_MAP_IMAGE_SECTIONS; s++){
+        if(header.sectionSize[s] != expected[s] || header.sectionOffset[s] % 8 != 0
+           || header.sectionOffset[s] > header.totalSize || header.sectionSize[s] > header.totalSize - header.sectionOffset[s]){
+            return false;
+        }
+    }
+    if(!validSections(const_cast<char*>(image), header)){
+        return false;
+    }
+    
+    m_image = image;
+    m_imageSize = header.totalSize;
+    
+    char* data = const_cast<char*>(image);
+    m_graph.m_numNodes = header.numNodes;
+    m_graph.m_numEdges = header.numEdges;
+    m_graph.m_indexMask = header.indexSlots - 1;
+    m_graph.m_keys = sectionData<GeoKey>(data, header, SECTION_COORD_KEYS);
+    m_graph.m_offsets = sectionData<EdgeID>(data, header, SECTION_EDGE_OFFSETS);
+    m_graph.m_sources = sectionData<NodeID>(data, header, SECTION_SOURCES);
+    m_graph.m_targets = sectionData<NodeID>(data, header, SECTION_TARGETS);
+    m_graph.m_twins = sectionData<EdgeID>(data, header, SECTION_TWINS);
+    m_graph.m_lengths = sectionData<double>(data, header, SECTION_LENGTHS);
+    m_graph.m_weights = m_graph.m_lengths;
+    m_speeds.reset(header.numEdges);
+    m_graph.m_edgeNames = sectionData<int32_t>(data, header, SECTION_EDGE_NAMES);
+    m_graph.m_nameOffsets = sectionData<uint32_t>(data, header, SECTION_NAME_OFFSETS);
+    m_graph.m_nameText = sectionData<char>(data, header, SECTION_NAME_TEXT);
+    m_graph.m_index = sectionData<NodeID>(data, header, SECTION_COORD_INDEX);
+    
+    m_nodePoints.clear();
+    m_nodePoints.reserve(header.numNodes);
+    for(uint32_t n = 0; n < header.numNodes; n++){
+        m_nodePoints.add(m_graph.latitude(n), m_graph.longitude(n));
+    }
+    m_graph.m_points = &m_nodePoints;
+    m_spatialIndex.build(m_graph);
+    return true;
+}
+
+bool StreetMapImpl::saveImage(string imageFile) const
+{
+    if(m_image == nullptr){ return false;}
+    
+    ofstream outfile(imageFile, ios::binary | ios::trunc);
+    if(!outfile){ return false;}
+    outfile.write(m_image, m_imageSize);
+    return bool(outfile);
+}
+
+bool StreetMapImpl::buildHierarchy()
 {
-    const vector<StreetSegment*> *v = map.find(gc); //?
+    if(m_graph.numNodes() == 0){ return false;}
     
-    if(v == nullptr){
+    delete m_hierarchy;
+    m_hierarchy = new ContractionHierarchy(m_graph);
+    return true;
+}
+
+bool StreetMapImpl::buildLandmarks(int numLandmarks, LandmarkStrategy strategy)
+{
+    if(m_graph.numNodes() == 0 || numLandmarks <= 0){ return false;}
+    
+    delete m_landmarks;
+    m_landmarks = new LandmarkTable(m_graph, numLandmarks, strategy);
+    return true;
+}
+
+bool StreetMapImpl::getSegmentsThatStartWith(const GeoCoord& gc, vector<StreetSegment>& segs) const
+{
+    NodeID n;
+    if(!m_graph.findNode(gc, n)){
         return false;
     }
     
-    for(auto it = v->begin(); it != v->end(); it++){
-        segs.push_back(*(*it));
+    for(EdgeID e : m_graph.edgesFrom(n)){
+        segs.push_back(m_graph.segment(e));
     }
     return true; 
 }
 
+EdgeRange StreetMapImpl::segmentsFrom(const GeoCoord& gc) const
+{
+    NodeID n;
+    if(!m_graph.findNode(gc, n)){
+        return EdgeRange();
+    }
+    return m_graph.edgesFrom(n);
+}
+
+bool StreetMapImpl::snapToNode(const GeoCoord& gc, GeoCoord& vertex) const
+{
+    NodeID n;
+    if(!m_graph.findNode(gc, n)){ //a vertex already, as written; keep it exactly
+        n = m_spatialIndex.nearestNode(gc.latitude, gc.longitude);
+        if(n == NO_NODE){
+            return false;
+        }
+    }
+    vertex = m_graph.coord(n);
+    return true;
+}
+
+bool StreetMapImpl::snapToNodes(const vector<GeoCoord>& coords, vector<GeoCoord>& vertices) const
+{
+    vertices.resize(coords.size());
+    if(m_graph.numNodes() == 0){
+        return false;
+    }
+    const int chunk = 256; //enough work per task to outweigh handing it out
+    int numChunks = (coords.size() + chunk - 1) / chunk;
+    sharedWorkerPool().parallelFor(numChunks, [&](int c){
+        int end = min((int)coords.size(), (c + 1) * chunk);
+        for(int i = c * chunk; i < end; i++){
+            snapToNode(coords[i], vertices[i]);
+        }
+    });
+    return true;
+}
+
+bool StreetMapImpl::snapToSegment(const GeoCoord& gc, StreetSegment& segment, GeoCoord& point) const
+{
+    double fraction;
+    EdgeID e = m_spatialIndex.nearestSegment(gc.latitude, gc.longitude, fraction);
+    if(e == NO_EDGE){
+        return false;
+    }
+    segment = m_graph.segment(e);
+    if(fraction == 0 || fraction == 1){ //an end of the segment, with its text as in the map
+        point = fraction == 0 ? segment.start : segment.end;
+        return true;
+    }
+    //rounded to the map's precision
+    char lat[16], lon[16];
+    formatFixed7((int32_t)llround((segment.start.latitude + fraction * (segment.end.latitude - segment.start.latitude)) * GEO_KEY_UNITS_PER_DEGREE), lat);
+    formatFixed7((int32_t)llround((segment.start.longitude + fraction * (segment.end.longitude - segment.start.longitude)) * GEO_KEY_UNITS_PER_DEGREE), lon);
+    point = GeoCoord(lat, lon);
+    return true;
+}
+
+//******************** segment weight changes ************************************
+
+bool StreetMapImpl::updateSegmentWeights(const vector<SegmentWeightChange>& changes)
+{
+    //the whole batch is checked first, so a bad change leaves the map as it was
+    vector<pair<EdgeID, double> > updates; //(edge, factor)
+    for(size_t i = 0; i < changes.size(); i++){
+        const SegmentWeightChange& c = changes[i];
+        NodeID start, end;
+        if(!(c.factor >= 1) || !m_graph.findNode(c.start, start) || !m_graph.findNode(c.end, end)){
+            return false;
+        }
+        size_t before = updates.size();
+        for(EdgeID e : m_graph.edgesFrom(start)){
+            if(m_graph.target(e) == end){
+                updates.push_back(make_pair(e, c.factor));
+                if(c.bothWays){
+                    updates.push_back(make_pair(m_graph.twin(e), c.factor));
+                }
+            }
+        }
+        if(updates.size() == before){ //no segment from start to end
+            return false;
+        }
+    }
+    
+    if(m_weights.empty()){ //the first change: from now on the graph reads a copy of the lengths
+        m_weights.assign(m_graph.m_lengths, m_graph.m_lengths + m_graph.numEdges());
+        m_graph.m_weights = m_weights.data();
+    }
+    vector<EdgeID> changed;
+    for(size_t i = 0; i < updates.size(); i++){
+        EdgeID e = updates[i].first;
+        double factor = updates[i].second;
+        double weight = factor == SEGMENT_CLOSED ? SEGMENT_CLOSED : m_graph.length(e) * factor; //0 km closed is still closed
+        if(weight != m_weights[e]){
+            m_weights[e] = weight;
+            changed.push_back(e);
+        }
+    }
+    reweigh(changed);
+    return true;
+}
+
+void StreetMapImpl::resetSegmentWeights()
+{
+    vector<EdgeID> changed;
+    for(EdgeID e = 0; e < (EdgeID)m_weights.size(); e++){
+        if(m_weights[e] != m_graph.length(e)){
+            changed.push_back(e);
+        }
+    }
+    m_weights.clear();
+    m_graph.m_weights = m_graph.m_lengths;
+    reweigh(changed);
+}
+
+  //brings the hierarchy up to date with the changed edges' weights, and makes cached routes stale
+void StreetMapImpl::reweigh(const vector<EdgeID>& changed)
+{
+    if(changed.empty()){
+        return;
+    }
+    if(m_hierarchy != nullptr){
+        m_hierarchy->update(m_graph.m_weights, changed);
+    }
+    m_version = nextMapVersion();
+}
+
+//******************** speed profiles ************************************
+
+bool StreetMapImpl::setStreetSpeedProfile(const string& streetName, int profile)
+{
+    if(profile < 0 || profile >= m_speeds.numProfiles()){
+        return false;
+    }
+    bool found = false;
+    for(EdgeID e = 0; e < m_graph.numEdges(); e++){
+        if(streetName == m_graph.streetName(e)){
+            m_speeds.setProfile(e, profile);
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool StreetMapImpl::setSegmentSpeedProfile(const GeoCoord& start, const GeoCoord& end, int profile, bool bothWays)
+{
+    NodeID from, to;
+    if(profile < 0 || profile >= m_speeds.numProfiles() || !m_graph.findNode(start, from) || !m_graph.findNode(end, to)){
+        return false;
+    }
+    bool found = false;
+    for(EdgeID e : m_graph.edgesFrom(from)){
+        if(m_graph.target(e) == to){
+            m_speeds.setProfile(e, profile);
+            if(bothWays){
+                m_speeds.setProfile(m_graph.twin(e), profile);
+            }
+            found = true;
+        }
+    }
+    return found;
+}
+
 //******************** StreetMap functions ************************************
 
 // These functions simply delegate to StreetMapImpl's functions.
@@ -120,11 +929,103 @@ bool StreetMap::load(string mapFile)
     return m_impl->load(mapFile);
 }
 
+bool StreetMap::saveImage(string imageFile) const
+{
+    return m_impl->saveImage(imageFile);
+}
+
 bool StreetMap::getSegmentsThatStartWith(const GeoCoord& gc, vector<StreetSegment>& segs) const
 {
    return m_impl->getSegmentsThatStartWith(gc, segs);
 }
 
+bool StreetMap::contains(const GeoCoord& gc) const
+{
+    NodeID n;
+    return m_impl->graph().findNode(gc, n);
+}
 
+EdgeRange StreetMap::segmentsFrom(const GeoCoord& gc) const
+{
+    return m_impl->segmentsFrom(gc);
+}
 
+bool StreetMap::snapToNode(const GeoCoord& gc, GeoCoord& vertex) const
+{
+    return m_impl->snapToNode(gc, vertex);
+}
+
+bool StreetMap::snapToNodes(const vector<GeoCoord>& coords, vector<GeoCoord>& vertices) const
+{
+    return m_impl->snapToNodes(coords, vertices);
+}
 
+bool StreetMap::snapToSegment(const GeoCoord& gc, StreetSegment& segment, GeoCoord& point) const
+{
+    return m_impl->snapToSegment(gc, segment, point);
+}
+
+const SpatialIndex& StreetMap::spatialIndex() const
+{
+    return m_impl->spatialIndex();
+}
+
+const StreetGraph& StreetMap::graph() const
+{
+    return m_impl->graph();
+}
+
+unsigned int StreetMap::version() const
+{
+    return m_impl->version();
+}
+
+bool StreetMap::buildHierarchy()
+{
+    return m_impl->buildHierarchy();
+}
+
+const ContractionHierarchy* StreetMap::hierarchy() const
+{
+    return m_impl->hierarchy();
+}
+
+bool StreetMap::buildLandmarks(int numLandmarks, LandmarkStrategy strategy)
+{
+    return m_impl->buildLandmarks(numLandmarks, strategy);
+}
+
+const LandmarkTable* StreetMap::landmarks() const
+{
+    return m_impl->landmarks();
+}
+
+bool StreetMap::updateSegmentWeights(const vector<SegmentWeightChange>& changes)
+{
+    return m_impl->updateSegmentWeights(changes);
+}
+
+void StreetMap::resetSegmentWeights()
+{
+    m_impl->resetSegmentWeights();
+}
+
+int StreetMap::addSpeedProfile(const vector<SpeedPoint>& points)
+{
+    return m_impl->addSpeedProfile(points);
+}
+
+bool StreetMap::setStreetSpeedProfile(const string& streetName, int profile)
+{
+    return m_impl->setStreetSpeedProfile(streetName, profile);
+}
+
+bool StreetMap::setSegmentSpeedProfile(const GeoCoord& start, const GeoCoord& end, int profile, bool bothWays)
+{
+    return m_impl->setSegmentSpeedProfile(start, end, profile, bothWays);
+}
+
+const SpeedProfiles& StreetMap::speedProfiles() const
+{
+    return m_impl->speedProfiles();
+}
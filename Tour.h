@@ -0,0 +1,110 @@
+#ifndef TOUR_INCLUDED
+#define TOUR_INCLUDED
+
+#include <vector>
+#include <algorithm>
+// Tour.h
+
+// A delivery order as a closed tour through the depot, over a row-major
+// size x size distance table whose point 0 is the depot. Positions 1 ... n
+// hold the stops; positions 0 and n + 1 both hold the depot, so every stop
+// has a predecessor and a successor.
+//
+// Every move is scored by the few edges it removes and adds, in O(1) and
+// without touching the tour, so a search can try a move before paying the
+// O(n) cost of applying it:
+//   swap(i, j)      exchange the stops at positions i and j
+//   reverse(i, j)   reverse positions i ... j (2-opt); this turns the edges
+//                   inside the segment around, so its delta is only exact for
+//                   symmetric tables
+//   move(i, len, j) take the len stops starting at position i and reinsert
+//                   them, in the same direction, after position j (Or-opt)
+class Tour
+{
+public:
+    Tour(const std::vector<double>& table, int size, const std::vector<int>& stops)
+     : m_table(table), m_size(size)
+    {
+        m_tour.push_back(0);
+        m_tour.insert(m_tour.end(), stops.begin(), stops.end());
+        m_tour.push_back(0);
+        m_length = measure();
+    }
+
+    int numStops() const { return m_tour.size() - 2; }
+    int at(int pos) const { return m_tour[pos]; }
+    double length() const { return m_length; }
+    double dist(int a, int b) const { return m_table[a * m_size + b]; }
+
+      // the stops in visiting order
+    std::vector<int> stops() const { return std::vector<int>(m_tour.begin() + 1, m_tour.end() - 1); }
+
+      // sums the edges again, free of the rounding that applied deltas accumulate
+    double measure() const
+    {
+        double total = 0;
+        for(size_t p = 0; p + 1 < m_tour.size(); p++){
+            total += dist(m_tour[p], m_tour[p + 1]);
+        }
+        return total;
+    }
+
+      // i < j, both stop positions
+    double swapDelta(int i, int j) const
+    {
+        int a = m_tour[i], b = m_tour[j];
+        int pa = m_tour[i - 1], na = m_tour[i + 1];
+        int pb = m_tour[j - 1], nb = m_tour[j + 1];
+        if(j == i + 1){
+            return dist(pa, b) + dist(b, a) + dist(a, nb) - dist(pa, a) - dist(a, b) - dist(b, nb);
+        }
+        return dist(pa, b) + dist(b, na) + dist(pb, a) + dist(a, nb) - dist(pa, a) - dist(a, na) - dist(pb, b) - dist(b, nb);
+    }
+
+    void applySwap(int i, int j)
+    {
+        m_length += swapDelta(i, j);
+        std::swap(m_tour[i], m_tour[j]);
+    }
+
+      // i < j, both stop positions
+    double reverseDelta(int i, int j) const
+    {
+        return dist(m_tour[i - 1], m_tour[j]) + dist(m_tour[i], m_tour[j + 1]) - dist(m_tour[i - 1], m_tour[i]) - dist(m_tour[j], m_tour[j + 1]);
+    }
+
+    void applyReverse(int i, int j)
+    {
+        m_length += reverseDelta(i, j);
+        std::reverse(m_tour.begin() + i, m_tour.begin() + j + 1);
+    }
+
+      // the segment is positions i ... i + len - 1, all stops; j is any position
+      // 0 ... n outside i - 1 ... i + len - 1
+    double moveDelta(int i, int len, int j) const
+    {
+        int a = m_tour[i], b = m_tour[i + len - 1];
+        int p = m_tour[i - 1], q = m_tour[i + len];
+        int x = m_tour[j], y = m_tour[j + 1];
+        return dist(p, q) - dist(p, a) - dist(b, q) + dist(x, a) + dist(b, y) - dist(x, y);
+    }
+
+    void applyMove(int i, int len, int j)
+    {
+        m_length += moveDelta(i, len, j);
+        if(j > i){
+            std::rotate(m_tour.begin() + i, m_tour.begin() + i + len, m_tour.begin() + j + 1);
+        }
+        else{
+            std::rotate(m_tour.begin() + j + 1, m_tour.begin() + i, m_tour.begin() + i + len);
+        }
+    }
+
+private:
+    const std::vector<double>& m_table;
+    int m_size;
+    std::vector<int> m_tour;
+    double m_length;
+};
+
+#endif // TOUR_INCLUDED
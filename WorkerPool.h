@@ -0,0 +1,134 @@
+#ifndef WORKER_POOL_INCLUDED
+#define WORKER_POOL_INCLUDED
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+// WorkerPool.h
+
+// A fixed set of worker threads fed from one queue. The only way work gets
+// in is parallelFor(count, task), which runs task(0) ... task(count-1) and
+// returns once all of them have finished. The calling thread claims indices
+// alongside the workers, and it waits for finished indices rather than for
+// the helper jobs themselves, so a task may call parallelFor on the same pool
+// (a batch of plans whose legs are routed in parallel) without deadlocking:
+// at worst the caller runs every index itself.
+class WorkerPool
+{
+public:
+      // numThreads <= 0 means one per hardware thread
+    WorkerPool(int numThreads = 0)
+     : m_stopping(false)
+    {
+        if(numThreads <= 0){
+            numThreads = std::max(1, (int)std::thread::hardware_concurrency());
+        }
+        for(int i = 0; i < numThreads; i++){
+            m_threads.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for(size_t i = 0; i < m_threads.size(); i++){
+            m_threads[i].join();
+        }
+    }
+
+    int numThreads() const { return m_threads.size(); }
+
+    template<typename Task>
+    void parallelFor(int count, const Task& task)
+    {
+        if(count <= 0){
+            return;
+        }
+
+        //helpers can outlive this call (queued behind other work), so the shared state is reference counted;
+        //they only touch task while an index is left, which can't happen once this call has returned
+        auto batch = std::make_shared<Batch>();
+        auto work = [batch, count, &task]() {
+            for(;;){
+                int i = batch->next++;
+                if(i >= count){
+                    return;
+                }
+                task(i);
+                if(++batch->done == count){
+                    std::lock_guard<std::mutex> guard(batch->lock);
+                    batch->finished.notify_all();
+                }
+            }
+        };
+
+        int helpers = std::min((int)m_threads.size(), count - 1);
+        if(helpers > 0){
+            {
+                std::lock_guard<std::mutex> guard(m_lock);
+                for(int h = 0; h < helpers; h++){
+                    m_jobs.push_back(work);
+                }
+            }
+            m_wake.notify_all();
+        }
+
+        work();
+        std::unique_lock<std::mutex> lock(batch->lock);
+        batch->finished.wait(lock, [&] { return batch->done == count; });
+    }
+
+      // We prevent a WorkerPool object from being copied or assigned.
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+private:
+    struct Batch{
+        std::atomic<int> next{0};   // next index to claim
+        std::atomic<int> done{0};   // indices finished
+        std::mutex lock;
+        std::condition_variable finished;
+    };
+
+    std::vector<std::thread> m_threads;
+    std::deque<std::function<void()> > m_jobs;
+    std::mutex m_lock;
+    std::condition_variable m_wake;
+    bool m_stopping;
+
+    void workerLoop()
+    {
+        for(;;){
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                m_wake.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+                if(m_jobs.empty()){
+                    return; //stopping, and nothing is left to run
+                }
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+            }
+            job();
+        }
+    }
+};
+
+  // process-wide pool, one thread per hardware thread, started on first use
+inline WorkerPool& sharedWorkerPool()
+{
+    static WorkerPool pool;
+    return pool;
+}
+
+#endif // WORKER_POOL_INCLUDED
@@ -8,12 +8,26 @@ using namespace std;
 
 bool loadDeliveryRequests(string deliveriesFile, GeoCoord& depot, vector<DeliveryRequest>& v);
 bool parseDelivery(string line, string& lat, string& lon, string& item);
+int planBatch(const StreetMap& sm, int numFiles, char* files[], Statistics* stats);
+void printStatistics(const Statistics* stats);
 
 int main(int argc, char *argv[])
 {
-    if (argc != 3)
+      // --stats, anywhere, prints search counters and latency histograms after the plans
+    bool showStats = false;
+    int numArgs = 0;
+    for (int i = 0; i < argc; i++)
     {
-        cout << "Usage: " << argv[0] << " mapdata.txt deliveries.txt" << endl;
+        if (string(argv[i]) == "--stats")
+            showStats = true;
+        else
+            argv[numArgs++] = argv[i];
+    }
+    argc = numArgs;
+
+    if (argc < 3)
+    {
+        cout << "Usage: " << argv[0] << " mapdata.txt deliveries.txt [more deliveries files...] [--stats]" << endl;
         return 1;
     }
 
@@ -25,6 +39,11 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    Statistics stats;
+    Statistics* statsIfShown = showStats ? &stats : nullptr;
+    if (argc > 3)
+        return planBatch(sm, argc - 2, argv + 2, statsIfShown);
+
     GeoCoord depot;
     vector<DeliveryRequest> deliveries;
     if (!loadDeliveryRequests(argv[2], depot, deliveries))
@@ -36,6 +55,7 @@ int main(int argc, char *argv[])
     cout << "Generating route...\n\n";
 
     DeliveryPlanner dp(&sm);
+    dp.setStatistics(statsIfShown);
     vector<DeliveryCommand> dcs;
     double totalMiles;
     DeliveryResult result = dp.generateDeliveryPlan(depot, deliveries, dcs, totalMiles);
@@ -56,6 +76,64 @@ int main(int argc, char *argv[])
     cout.setf(ios::fixed);
     cout.precision(2);
     cout << totalMiles << " miles travelled for all deliveries." << endl;
+    printStatistics(statsIfShown);
+}
+
+  // plans one manifest per file against the same map, in parallel
+int planBatch(const StreetMap& sm, int numFiles, char* files[], Statistics* searchStats)
+{
+    vector<DeliveryJob> jobs(numFiles);
+    for (int i = 0; i < numFiles; i++)
+    {
+        if (!loadDeliveryRequests(files[i], jobs[i].depot, jobs[i].deliveries))
+        {
+            cout << "Unable to load delivery request file " << files[i] << endl;
+            return 1;
+        }
+    }
+
+    cout << "Generating " << numFiles << " routes...\n";
+
+    DeliveryPlanner dp(&sm);
+    dp.setStatistics(searchStats);
+    vector<DeliveryJobResult> results;
+    DeliveryBatchStats stats = dp.generateDeliveryPlans(jobs, results);
+
+    cout.setf(ios::fixed);
+    cout.precision(2);
+    int failures = 0;
+    for (int i = 0; i < numFiles; i++)
+    {
+        cout << "\n" << files[i] << " (" << results[i].seconds * 1000 << " ms):\n";
+        if (results[i].result == BAD_COORD)
+            cout << "One or more depot or delivery coordinates are invalid." << endl;
+        else if (results[i].result == NO_ROUTE)
+            cout << "No route can be found to deliver all items." << endl;
+        else
+        {
+            cout << "Starting at the depot...\n";
+            for (const auto& dc : results[i].commands)
+                cout << dc.description() << endl;
+            cout << "You are back at the depot and your deliveries are done!\n";
+            cout << results[i].totalDistanceTravelled << " miles travelled for all deliveries." << endl;
+        }
+        if (results[i].result != DELIVERY_SUCCESS)
+            failures++;
+    }
+
+    cout << "\n" << stats.numJobs << " routes in " << stats.seconds * 1000 << " ms ("
+         << stats.jobsPerSecond << " per second, " << stats.meanJobSeconds * 1000 << " ms mean, "
+         << stats.maxJobSeconds * 1000 << " ms max per route)" << endl;
+    printStatistics(searchStats);
+    return failures == 0 ? 0 : 1;
+}
+
+void printStatistics(const Statistics* stats)
+{
+    if (stats == nullptr)
+        return;
+    cout << "\nSearch statistics:\n";
+    stats->dump(cout);
 }
 
 bool loadDeliveryRequests(string deliveriesFile, GeoCoord& depot, vector<DeliveryRequest>& v)
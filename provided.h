@@ -1,19 +1,36 @@
 #ifndef PROVIDED_INCLUDED
 #define PROVIDED_INCLUDED
 
-// YOU MUST MAKE NO CHANGES TO THIS FILE!
+// Public interface shared by the map, router, optimizer and planner.
 
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <vector>
 #include <list>
+#include <limits>
 
 enum DeliveryResult
 {
     DELIVERY_SUCCESS, NO_ROUTE, BAD_COORD
 };
 
+  // search used by a PointToPointRouter
+enum RouteAlgorithm
+{
+    ROUTE_ASTAR,                    // A* with a straight-line heuristic, no preprocessing
+    ROUTE_CONTRACTION_HIERARCHY,    // needs StreetMap::buildHierarchy, falls back to A* without it
+    ROUTE_BIDIRECTIONAL_ASTAR,      // A* from both ends at once, no preprocessing
+    ROUTE_ALT                       // A* with landmark bounds, needs StreetMap::buildLandmarks
+};
+
+  // how StreetMap::buildLandmarks places landmarks
+enum LandmarkStrategy
+{
+    LANDMARKS_FARTHEST,             // each one as far as possible from the previous ones
+    LANDMARKS_AVOID                 // where the current landmarks give the weakest bounds
+};
+
 struct GeoCoord
 {
     GeoCoord(std::string lat, std::string lon)
@@ -30,11 +47,10 @@ struct GeoCoord
     double      longitude;
 };
 
-inline
-bool operator==(const GeoCoord& lhs, const GeoCoord& rhs)
-{
-    return lhs.latitudeText == rhs.latitudeText  &&  lhs.longitudeText == rhs.longitudeText;
-}
+  // Coordinates compare by value at the maps' precision of 1e-7 degrees, so
+  // "34.0547" and "34.0547000" are the same point; the map hands its own
+  // coordinates back written with exactly seven decimals (see GeoKey.h).
+bool operator==(const GeoCoord& lhs, const GeoCoord& rhs);
 
 inline
 bool operator!=(const GeoCoord& lhs, const GeoCoord& rhs)
@@ -43,13 +59,7 @@ bool operator!=(const GeoCoord& lhs, const GeoCoord& rhs)
 }
 
   // This would be needed only if something required some ordering relation
-inline
-bool operator<(const GeoCoord& lhs, const GeoCoord& rhs)
-{
-    if (lhs.latitudeText < rhs.latitudeText) return true;
-    if (rhs.latitudeText < lhs.latitudeText) return false;
-    return lhs.longitudeText < rhs.longitudeText;
-}
+bool operator<(const GeoCoord& lhs, const GeoCoord& rhs);
 
 struct StreetSegment
 {
@@ -71,15 +81,140 @@ bool operator==(const StreetSegment& lhs, const StreetSegment& rhs)
     return lhs.start == rhs.start  &&  lhs.end == rhs.end;
 }
 
-class StreetMapImpl;
+typedef int NodeID;  // dense id of a map vertex (see StreetGraph.h)
+typedef int EdgeID;  // dense id of a directed street segment
+
+  // The ids of the segments leaving one vertex. Edge ids index the map's stored
+  // arrays directly, so iterating a range copies and allocates nothing.
+class EdgeRange
+{
+public:
+    class iterator
+    {
+    public:
+        explicit iterator(EdgeID e) : m_edge(e) {}
+        EdgeID operator*() const { return m_edge; }
+        iterator& operator++() { m_edge++; return *this; }
+        bool operator==(const iterator& other) const { return m_edge == other.m_edge; }
+        bool operator!=(const iterator& other) const { return m_edge != other.m_edge; }
+    private:
+        EdgeID m_edge;
+    };
+
+    EdgeRange()
+     : m_begin(0), m_end(0)
+    {}
+
+    EdgeRange(EdgeID begin, EdgeID end)
+     : m_begin(begin), m_end(end)
+    {}
+
+    iterator begin() const { return iterator(m_begin); }
+    iterator end() const { return iterator(m_end); }
+    int size() const { return m_end - m_begin; }
+    bool empty() const { return m_begin == m_end; }
+
+private:
+    EdgeID m_begin;
+    EdgeID m_end;
+};
+
+  // A change to what routing pays for the segment from start to end (all of
+  // them, if the map has several): its length times factor. Factors are at
+  // least 1, so the distance bounds the searches rely on still hold; 1 undoes
+  // earlier changes and SEGMENT_CLOSED closes the segment.
+const double SEGMENT_CLOSED = std::numeric_limits<double>::infinity();
+
+struct SegmentWeightChange
+{
+    SegmentWeightChange(const GeoCoord& s, const GeoCoord& e, double f, bool both = true)
+     : start(s), end(e), factor(f), bothWays(both)
+    {}
+    GeoCoord start;
+    GeoCoord end;
+    double factor;
+    bool bothWays;      // end to start as well
+};
+
+  // One breakpoint of a time-of-day speed profile (StreetMap::addSpeedProfile).
+  // Speeds change linearly from each breakpoint to the next, and from the
+  // last one to the first one of the next day.
+struct SpeedPoint
+{
+    SpeedPoint(double m, double s)
+     : minute(m), mph(s)
+    {}
+    double minute;      // after midnight, in [0, 1440)
+    double mph;
+};
 
+class StreetMapImpl;
+class StreetGraph;
+class ContractionHierarchy;
+class LandmarkTable;
+class SpatialIndex;
+class SpeedProfiles;
+
+  // Thread safety: const member functions may be called from any number of
+  // threads at once, as long as no thread is inside a non-const one (load,
+  // buildHierarchy, buildLandmarks, the segment weight and speed profile
+  // changes). Routers, optimizers and planners only ever call the const ones.
 class StreetMap
 {
 public:
     StreetMap();
     ~StreetMap();
+      // loads either a text map or a compiled image written by saveImage
     bool load(std::string mapFile);
+      // writes the loaded map as a binary image that load() can mmap
+    bool saveImage(std::string imageFile) const;
     bool getSegmentsThatStartWith(const GeoCoord& gc, std::vector<StreetSegment>& segs) const;
+      // true if gc is a vertex of the map; no segments are copied
+    bool contains(const GeoCoord& gc) const;
+      // non-allocating view of the segments that start at gc (empty if gc is not a vertex);
+      // read them through graph().target(e), graph().streetName(e), ...
+    EdgeRange segmentsFrom(const GeoCoord& gc) const;
+      // the vertex nearest to gc in a straight line, for coordinates that
+      // aren't vertices themselves; false if no map is loaded (see SpatialIndex.h)
+    bool snapToNode(const GeoCoord& gc, GeoCoord& vertex) const;
+      // snapToNode for many coordinates, several at a time: vertices[i] for coords[i]
+    bool snapToNodes(const std::vector<GeoCoord>& coords, std::vector<GeoCoord>& vertices) const;
+      // the point on any street segment nearest to gc, and that segment
+    bool snapToSegment(const GeoCoord& gc, StreetSegment& segment, GeoCoord& point) const;
+    const SpatialIndex& spatialIndex() const;
+      // integer-id adjacency view of the loaded map (see StreetGraph.h)
+    const StreetGraph& graph() const;
+      // changes whenever the map data changes (each load or weight change), so caches of routes can tell they are stale
+    unsigned int version() const;
+      // optional preprocessing for ROUTE_CONTRACTION_HIERARCHY; call after load
+    bool buildHierarchy();
+      // nullptr until buildHierarchy has run on the loaded map
+    const ContractionHierarchy* hierarchy() const;
+      // optional preprocessing for ROUTE_ALT: one distance table per landmark
+      // (8 bytes per map vertex each, see LandmarkTable::memoryUsage)
+    bool buildLandmarks(int numLandmarks, LandmarkStrategy strategy = LANDMARKS_AVOID);
+      // nullptr until buildLandmarks has run on the loaded map
+    const LandmarkTable* landmarks() const;
+      // closures and slowdowns, applied as one batch without reloading: routes
+      // avoid closed segments and weigh slowed ones from now on, while the
+      // distances they report stay the segments' lengths. A built hierarchy
+      // is updated only where the changes reach, and landmarks stay valid.
+      // False, with nothing changed, if some segment isn't on the map or some
+      // factor is below 1. Compiled images don't include the changes.
+    bool updateSegmentWeights(const std::vector<SegmentWeightChange>& changes);
+      // undoes every weight change
+    void resetSegmentWeights();
+      // time-of-day speeds for travel-time routing (see SpeedProfiles.h).
+      // Every segment starts on profile 0, a constant 25 mph. A profile is
+      // stored once and can then be given to any number of streets or
+      // segments; addSpeedProfile returns its id, or -1 if the breakpoints
+      // aren't increasing minutes of one day with positive speeds.
+    int addSpeedProfile(const std::vector<SpeedPoint>& points);
+      // every segment of the street; false if there is none, or no such profile
+    bool setStreetSpeedProfile(const std::string& streetName, int profile);
+      // the segments from start to end (and end to start, if bothWays)
+    bool setSegmentSpeedProfile(const GeoCoord& start, const GeoCoord& end, int profile, bool bothWays = true);
+    const SpeedProfiles& speedProfiles() const;
       // We prevent a StreetMap object from being copied or assigned.
     StreetMap(const StreetMap&) = delete;
     StreetMap& operator=(const StreetMap&) = delete;
@@ -87,18 +222,136 @@ private:
     StreetMapImpl* m_impl;
 };
 
+class RouteCacheImpl;
+
+  // Optional cache of computed routes keyed on their start and end points,
+  // holding at most capacity routes and dropping the least recently used ones
+  // (see RouteCache.h). One cache can be shared by any number of routers and
+  // planners, on any threads. Routes from an older version of a map are never
+  // returned.
+class RouteCache
+{
+public:
+    RouteCache(int capacity = 4096);
+    ~RouteCache();
+    long long hits() const;
+    long long misses() const;
+    int size() const;
+      // drops every route and zeroes the counters
+    void clear();
+      // We prevent a RouteCache object from being copied or assigned.
+    RouteCache(const RouteCache&) = delete;
+    RouteCache& operator=(const RouteCache&) = delete;
+private:
+    friend class PointToPointRouterImpl;
+    RouteCacheImpl* m_impl;
+};
+
+  // What a Statistics counts, summed over every query it was given
+enum StatCounter
+{
+    STAT_NODES_SETTLED,
+    STAT_HEAP_PUSHES,
+    STAT_HEAP_POPS,
+    STAT_HEAP_DECREASES,        // keys lowered in place (a heap without decrease-key would pop these later as stale entries)
+    STAT_HASH_PROBES,           // keys compared in the coordinate index and the route cache
+    STAT_HASH_RESIZES,          // route cache tables grown
+    STAT_OPTIMIZER_ITERATIONS,  // annealing moves tried
+    STAT_OPTIMIZER_ACCEPTANCES, // and made
+    NUM_STAT_COUNTERS
+};
+
+  // What a Statistics times
+enum StatTimer
+{
+    STAT_ROUTE_TIME,            // generatePointToPointRoute and generateTimedRoute
+    STAT_OPTIMIZE_TIME,         // optimizeDeliveryOrder
+    STAT_PLAN_TIME,             // one plan of a DeliveryPlanner, or one vehicle's of a fleet plan
+    NUM_STAT_TIMERS
+};
+
+class StatisticsImpl;
+
+  // Optional search counters and latency histograms, given to routers,
+  // optimizers and planners with setStatistics (see Statistics.h). One
+  // Statistics can be shared by any number of them, on any threads; it is
+  // updated with atomic adds, once per query. Without one, queries run code
+  // compiled without counting and don't read the clock.
+class Statistics
+{
+public:
+    Statistics();
+    ~Statistics();
+    long long counter(StatCounter c) const;
+      // number of calls timed
+    long long samples(StatTimer t) const;
+    double meanSeconds(StatTimer t) const;
+      // upper bound of the histogram bucket holding the fraction p (0 to 1)
+      // of the calls; histogram buckets are powers of two microseconds
+    double percentileSeconds(StatTimer t, double p) const;
+      // zeroes everything
+    void clear();
+      // every counter, then every timer's samples, mean and percentiles
+      // followed by its nonempty histogram buckets
+    void dump(std::ostream& out) const;
+      // We prevent a Statistics object from being copied or assigned.
+    Statistics(const Statistics&) = delete;
+    Statistics& operator=(const Statistics&) = delete;
+private:
+    friend class PointToPointRouterImpl;
+    friend class DeliveryOptimizerImpl;
+    friend class DeliveryPlannerImpl;
+    StatisticsImpl* m_impl;
+};
+
 class PointToPointRouterImpl;
 
+  // Thread safety: the generate functions may run on any number of threads at
+  // once (every thread searches in its own workspace,
+  // see SearchWorkspace.h), provided the map is not being modified and
+  // neither setRouteCache nor setStatistics is called meanwhile.
 class PointToPointRouter
 {
 public:
-    PointToPointRouter(const StreetMap* sm);
+    PointToPointRouter(const StreetMap* sm, RouteAlgorithm algorithm = ROUTE_ASTAR);
     ~PointToPointRouter();
     DeliveryResult generatePointToPointRoute(
         const GeoCoord& start,
         const GeoCoord& end,
         std::list<StreetSegment>& route,
         double& totalDistanceTravelled) const;
+      // the quickest route leaving start at departure (minutes after midnight,
+      // possibly days later) by the map's speed profiles, and when it reaches
+      // end. Always a time-dependent A*, whatever the router's algorithm, and
+      // never cached.
+    DeliveryResult generateTimedRoute(
+        const GeoCoord& start,
+        const GeoCoord& end,
+        double departure,
+        std::list<StreetSegment>& route,
+        double& totalDistanceTravelled,
+        double& arrival) const;
+      // the same routes as the edge ids of their segments, in order (see
+      // StreetGraph.h), without building StreetSegments; path is replaced
+    DeliveryResult generatePointToPointPath(
+        const GeoCoord& start,
+        const GeoCoord& end,
+        std::vector<EdgeID>& path,
+        double& totalDistanceTravelled) const;
+    DeliveryResult generateTimedPath(
+        const GeoCoord& start,
+        const GeoCoord& end,
+        double departure,
+        std::vector<EdgeID>& path,
+        double& totalDistanceTravelled,
+        double& arrival) const;
+      // look up and remember routes in cache (nullptr for none, the default)
+    void setRouteCache(RouteCache* cache);
+      // route from and to the nearest vertex within miles of a start or end
+      // that isn't a vertex itself (0, the default: BAD_COORD instead)
+    void setSnapDistance(double miles);
+      // count searches and time routes into stats (nullptr for none, the default)
+    void setStatistics(Statistics* stats);
       // We prevent a PointToPointRouter object from being copied or assigned.
     PointToPointRouter(const PointToPointRouter&) = delete;
     PointToPointRouter& operator=(const PointToPointRouter&) = delete;
@@ -106,6 +359,32 @@ private:
     PointToPointRouterImpl* m_impl;
 };
 
+class DistanceMatrixImpl;
+
+  // Road distances between every ordered pair of a set of map points, found by
+  // a many-to-many search (CH buckets when StreetMap::buildHierarchy has run,
+  // otherwise one Dijkstra per point that stops once every point is settled)
+  // rather than a separate route per pair.
+class DistanceMatrix
+{
+public:
+    DistanceMatrix(const StreetMap* sm);
+    ~DistanceMatrix();
+      // BAD_COORD if some point is not a map vertex
+    DeliveryResult compute(const std::vector<GeoCoord>& points);
+      // number of points of the last successful compute
+    int size() const;
+      // road miles from points[from] to points[to], counting slowed segments
+      // at their weight (see SegmentWeightChange); infinite if there is no route
+    double distance(int from, int to) const;
+    bool reachable(int from, int to) const;
+      // We prevent a DistanceMatrix object from being copied or assigned.
+    DistanceMatrix(const DistanceMatrix&) = delete;
+    DistanceMatrix& operator=(const DistanceMatrix&) = delete;
+private:
+    DistanceMatrixImpl* m_impl;
+};
+
 struct DeliveryRequest
 {
     DeliveryRequest(std::string it, const GeoCoord& loc)
@@ -115,8 +394,31 @@ struct DeliveryRequest
     GeoCoord location;
 };
 
+  // How DeliveryOptimizer anneals. Chains start from the given order, each with
+  // its own random stream derived from seed, and the shortest result wins, so
+  // the same seed and number of chains always give the same order.
+struct AnnealingOptions
+{
+    AnnealingOptions()
+     : chains(4), iterations(0), startTemperature(0), endTemperature(0), seed(5489), timeLimit(0)
+    {}
+    int chains;                 // independent chains, run in parallel; 0 for one per hardware thread
+    long long iterations;       // moves tried per chain; 0 for 2000 per stop (at most a million)
+    double startTemperature;    // in the table's units; 0 to derive it from the average leg
+    double endTemperature;      // 0 for startTemperature / 1000
+    unsigned int seed;
+    double timeLimit;           // seconds per chain, 0 for none; results then depend on machine speed
+};
+
 class DeliveryOptimizerImpl;
 
+  // Manifests of more than 200 stops skip annealing (and AnnealingOptions) for
+  // a deterministic neighbor-list local search that doesn't tabulate crow
+  // distances between every pair of stops.
+  //
+  // Thread safety: optimizeDeliveryOrder may run on any number of threads at
+  // once; each call draws from its own random generator, so results don't
+  // depend on what other threads are doing.
 class DeliveryOptimizer
 {
 public:
@@ -127,6 +429,19 @@ public:
         std::vector<DeliveryRequest>& deliveries,
         double& oldCrowDistance,
         double& newCrowDistance) const;
+      // the same, but measuring tours in road miles; roadDistances must have been
+      // computed for the depot followed by the deliveries in their current order
+      // (it falls back to crow distances if the sizes don't match)
+    void optimizeDeliveryOrder(
+        const GeoCoord& depot,
+        std::vector<DeliveryRequest>& deliveries,
+        const DistanceMatrix& roadDistances,
+        double& oldDistance,
+        double& newDistance) const;
+    void setAnnealingOptions(const AnnealingOptions& options);
+      // count annealing moves and time optimizations into stats (nullptr for
+      // none, the default); large manifests' local search isn't counted
+    void setStatistics(Statistics* stats);
       // We prevent a DeliveryOptimizer object from being copied or assigned.
     DeliveryOptimizer(const DeliveryOptimizer&) = delete;
     DeliveryOptimizer& operator=(const DeliveryOptimizer&) = delete;
@@ -208,18 +523,174 @@ private:
     double       m_distance;    // 1.92 (in miles)
 };
 
+  // Direction of a compact Proceed command: which of the sectors of
+  // angleOfLine that DeliveryPlanner has always used, under the name it has
+  // always printed for it. For compatibility those names are kept as they
+  // are, so 292.5 to 337.5 degrees is HEADING_EAST and 337.5 to 360 is
+  // HEADING_SOUTHEAST.
+enum Heading : unsigned char
+{
+    HEADING_EAST, HEADING_NORTHEAST, HEADING_NORTH, HEADING_NORTHWEST,
+    HEADING_WEST, HEADING_SOUTHWEST, HEADING_SOUTH, HEADING_SOUTHEAST,
+    HEADING_UNKNOWN                 // printed as "error"
+};
+
+enum TurnDirection : unsigned char
+{
+    TURN_LEFT, TURN_RIGHT
+};
+
+  // A DeliveryCommand without strings, 16 bytes
+struct CompactCommand
+{
+    enum Kind : unsigned char { PROCEED, TURN, DELIVER };
+    Kind kind;
+    unsigned char direction;    // a Heading for PROCEED, a TurnDirection for TURN
+    int id;                     // PROCEED and TURN: the street's interned name id (see
+                                // DeliveryCommandList::streetName); DELIVER: the item's index
+    double miles;               // PROCEED only
+};
+
+  // The commands of a plan as CompactCommands, from
+  // DeliveryPlanner::generateCompactDeliveryPlan. Street names are kept as the
+  // map's name ids and items once each, so making a plan copies no street
+  // names. Text is only made when asked for, one command at a time or all at
+  // once into one buffer, and reads exactly as DeliveryCommand::description.
+  // The list refers to its StreetMap for the names, so it must not outlive it.
+class DeliveryCommandList
+{
+public:
+    DeliveryCommandList()
+     : m_sm(nullptr)
+    {}
+      // empties the list for commands on sm's streets; its memory is kept
+    void clear(const StreetMap* sm);
+    void append(const CompactCommand& command) { m_commands.push_back(command); }
+      // a DELIVER command for a new item
+    void appendDeliver(const std::string& item);
+    int size() const { return m_commands.size(); }
+    const CompactCommand& operator[](int i) const { return m_commands[i]; }
+    const char* streetName(int nameId) const;
+    const std::string& item(int itemId) const { return m_items[itemId]; }
+    std::string description(int i) const;
+      // appends every command's description to text, each followed by '\n'
+    void render(std::string& text) const;
+      // appends the same commands to commands
+    void toDeliveryCommands(std::vector<DeliveryCommand>& commands) const;
+private:
+    const StreetMap* m_sm;
+    std::vector<CompactCommand> m_commands;
+    std::vector<std::string> m_items;
+
+    void appendDescription(const CompactCommand& command, std::string& text) const;
+};
+
+  // one driver's manifest for DeliveryPlanner::generateDeliveryPlans
+struct DeliveryJob
+{
+    DeliveryJob()
+    {}
+    DeliveryJob(const GeoCoord& d, const std::vector<DeliveryRequest>& dels)
+     : depot(d), deliveries(dels)
+    {}
+    GeoCoord depot;
+    std::vector<DeliveryRequest> deliveries;
+};
+
+struct DeliveryJobResult
+{
+    DeliveryJobResult()
+     : result(DELIVERY_SUCCESS), totalDistanceTravelled(0), seconds(0)
+    {}
+    DeliveryResult result;
+    std::vector<DeliveryCommand> commands;
+    double totalDistanceTravelled;
+    double seconds;             // wall time spent planning this job
+};
+
+struct DeliveryBatchStats
+{
+    int numJobs;
+    double seconds;             // wall time of the whole batch
+    double jobsPerSecond;
+    double meanJobSeconds;
+    double maxJobSeconds;
+};
+
+  // One vehicle's part of a fleet plan
+struct VehiclePlan
+{
+    VehiclePlan()
+     : result(DELIVERY_SUCCESS), totalDistanceTravelled(0)
+    {}
+    DeliveryResult result;
+    std::vector<DeliveryRequest> deliveries;    // in the order they are made
+    std::vector<DeliveryCommand> commands;
+    double totalDistanceTravelled;
+};
+
 class DeliveryPlannerImpl;
 
+  // Thread safety: the const member functions may run on any number of threads
+  // at once, under the same conditions as PointToPointRouter's.
+
 class DeliveryPlanner
 {
 public:
-    DeliveryPlanner(const StreetMap* sm);
+    DeliveryPlanner(const StreetMap* sm, RouteAlgorithm algorithm = ROUTE_ASTAR);
     ~DeliveryPlanner();
     DeliveryResult generateDeliveryPlan(
         const GeoCoord& depot,
         const std::vector<DeliveryRequest>& deliveries,
         std::vector<DeliveryCommand>& commands,
         double& totalDistanceTravelled) const;
+      // the same, but every leg is a quickest route by the map's speed
+      // profiles (see PointToPointRouter::generateTimedRoute): the first
+      // leaves the depot at departure and each later one when the one before
+      // arrives. arrivals[k] is when leg k ends, at the (k+1)th DELIVER
+      // command or, for the last, back at the depot. NO_ROUTE if any leg has
+      // no route.
+    DeliveryResult generateTimedDeliveryPlan(
+        const GeoCoord& depot,
+        const std::vector<DeliveryRequest>& deliveries,
+        double departure,
+        std::vector<DeliveryCommand>& commands,
+        double& totalDistanceTravelled,
+        std::vector<double>& arrivals) const;
+      // the same plan as generateDeliveryPlan, into a compact list that
+      // replaces commands' contents
+    DeliveryResult generateCompactDeliveryPlan(
+        const GeoCoord& depot,
+        const std::vector<DeliveryRequest>& deliveries,
+        DeliveryCommandList& commands,
+        double& totalDistanceTravelled) const;
+      // plans every job, several at a time, into results[i] for jobs[i];
+      // the jobs share this planner's map, router and route cache
+    DeliveryBatchStats generateDeliveryPlans(
+        const std::vector<DeliveryJob>& jobs,
+        std::vector<DeliveryJobResult>& results) const;
+      // splits deliveries among numVehicles vehicles that all start and end at
+      // depot, then plans every vehicle's route, several at a time; plans[v]
+      // is vehicle v's. capacities[v], if given, is the most deliveries
+      // vehicle v can take (0 for no limit). Returns NO_ROUTE if the
+      // capacities can't hold every delivery, otherwise the first vehicle
+      // result that isn't DELIVERY_SUCCESS, if any. See FleetPartition.h.
+    DeliveryResult generateFleetPlan(
+        const GeoCoord& depot,
+        const std::vector<DeliveryRequest>& deliveries,
+        int numVehicles,
+        std::vector<VehiclePlan>& plans,
+        double& totalDistanceTravelled,
+        const std::vector<int>& capacities = std::vector<int>()) const;
+      // route the plan's legs through cache (nullptr for none, the default)
+    void setRouteCache(RouteCache* cache);
+      // as PointToPointRouter's, for the depot and every delivery
+    void setSnapDistance(double miles);
+      // how the delivery order is optimized before routing
+    void setAnnealingOptions(const AnnealingOptions& options);
+      // time plans into stats, and count and time the routes and optimizations
+      // they are made of (nullptr for none, the default)
+    void setStatistics(Statistics* stats);
       // We prevent a DeliveryPlanner object from being copied or assigned.
     DeliveryPlanner(const DeliveryPlanner&) = delete;
     DeliveryPlanner& operator=(const DeliveryPlanner&) = delete;
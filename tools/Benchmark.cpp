@@ -0,0 +1,690 @@
+// Benchmark.cpp
+// Microbenchmarks for the routing code. Build it together with every source
+// file except main.cpp, e.g.
+//
+//     g++ -std=c++17 -O2 -o Benchmark tools/Benchmark.cpp $(ls *.cpp | grep -v main.cpp)
+//
+//     Benchmark hashmap [numKeys]
+//         ExpandableHashMap vs FlatHashMap: insert, hit and miss lookups, and
+//         reset-and-refill rounds like the A* open and closed lists do, for
+//         node ids, GeoCoords and the GeoKeys map nodes are stored as.
+//
+//     Benchmark route mapFile [numQueries] [numLandmarks]
+//         Point-to-point query latency and settled nodes per query for every
+//         RouteAlgorithm, on the same random node pairs.
+//
+//     Benchmark crow mapFile [numPoints]
+//         The batch crow-distance kernel (CrowDistance.h) against
+//         distanceEarthKM: N x N matrix time, and an accuracy check on map
+//         nodes plus points spread over the globe. Exits with 1 if the kernel
+//         is off by more than 1e-9 relative anywhere.
+//
+//     Benchmark tour mapFile [numStops ...]
+//         Delivery ordering on synthetic manifests of distinct map nodes
+//         (100, 1000 and 5000 stops by default): DeliveryOptimizer, which
+//         switches from annealing to NeighborListSearch above 200 stops, and
+//         NeighborListSearch on its own, with time and crow miles before and
+//         after.
+//
+//     Benchmark snap mapFile [numPoints]
+//         Snapping coordinates that aren't map vertices (SpatialIndex.h):
+//         nearest node and nearest segment per query, and the batch
+//         StreetMap::snapToNodes in coordinates per second.
+//
+//     Benchmark load mapFile [copies]
+//         Text map load time, best of three, on mapFile and on a synthetic map
+//         made of copies of it (50 by default, each moved half a degree north
+//         so no vertex is shared), next to loading the same maps as compiled
+//         images. The synthetic map and the images are temporary files beside
+//         mapFile.
+//
+//     Benchmark suite mapFile [numQueries] [numManifests] [numStops ...]
+//         End to end, as CSV for tracking across versions: StreetMap::load,
+//         generatePointToPointRoute with every RouteAlgorithm on numQueries
+//         random node pairs (1000), and optimizeDeliveryOrder and
+//         generateDeliveryPlan (CH routing) on numManifests random manifests
+//         (50) of each size (10 and 50 stops), all within the map's largest
+//         connected piece. Every row gives p50, p95 and
+//         p99 latency from running the samples one at a time, and throughput
+//         from running them all again on every worker thread. The workload
+//         is the same on every run.
+
+#include "../provided.h"
+#include "../ExpandableHashMap.h"
+#include "../FlatHashMap.h"
+#include "../GeoKey.h"
+#include "../StreetGraph.h"
+#include "../SearchWorkspace.h"
+#include "../ContractionHierarchy.h"
+#include "../Landmarks.h"
+#include "../CrowDistance.h"
+#include "../NeighborListSearch.h"
+#include "../SpatialIndex.h"
+#include "../WorkerPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+namespace {
+
+double secondsSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+  // small deterministic generator so every run measures the same workload
+unsigned int nextRandom(unsigned int& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+template<typename Map, typename Key>
+void benchmarkMap(const char* name, const vector<Key>& keys, const vector<Key>& missing, int rounds)
+{
+    auto start = chrono::steady_clock::now();
+    double insertTime = 0, hitTime = 0, missTime = 0;
+    long found = 0;
+
+    Map map;
+    for(int r = 0; r < rounds; r++){
+        map.reset();
+
+        auto t = chrono::steady_clock::now();
+        for(size_t i = 0; i < keys.size(); i++){
+            map.associate(keys[i], int(i));
+        }
+        insertTime += secondsSince(t);
+
+        t = chrono::steady_clock::now();
+        for(size_t i = 0; i < keys.size(); i++){
+            found += map.find(keys[i]) != nullptr;
+        }
+        hitTime += secondsSince(t);
+
+        t = chrono::steady_clock::now();
+        for(size_t i = 0; i < missing.size(); i++){
+            found += map.find(missing[i]) != nullptr;
+        }
+        missTime += secondsSince(t);
+    }
+
+    double ops = double(keys.size()) * rounds;
+    printf("%-36s insert %7.1f ns  hit %7.1f ns  miss %7.1f ns  total %.3f s  (%ld found)\n",
+           name, insertTime * 1e9 / ops, hitTime * 1e9 / ops, missTime * 1e9 / ops, secondsSince(start), found);
+}
+
+int benchmarkHashMaps(int numKeys)
+{
+    unsigned int state = 42;
+    vector<NodeID> ids, missingIds;
+    vector<GeoCoord> coords, missingCoords;
+    for(int i = 0; i < numKeys; i++){
+        ids.push_back(nextRandom(state) % (numKeys * 4) * 2);  //even ids are present
+        missingIds.push_back(nextRandom(state) % (numKeys * 4) * 2 + 1);
+        coords.push_back(GeoCoord("34.0" + to_string(nextRandom(state) % 10000000), "-118.4" + to_string(nextRandom(state) % 10000000)));
+        missingCoords.push_back(GeoCoord("35.0" + to_string(nextRandom(state) % 10000000), "-118.4" + to_string(nextRandom(state) % 10000000)));
+    }
+
+    int rounds = 20;
+    printf("%d keys, %d reset-and-refill rounds\n", numKeys, rounds);
+    benchmarkMap<ExpandableHashMap<NodeID, int> >("ExpandableHashMap<NodeID, int>", ids, missingIds, rounds);
+    benchmarkMap<FlatHashMap<NodeID, int> >("FlatHashMap<NodeID, int>", ids, missingIds, rounds);
+    benchmarkMap<ExpandableHashMap<GeoCoord, int> >("ExpandableHashMap<GeoCoord, int>", coords, missingCoords, rounds);
+    benchmarkMap<FlatHashMap<GeoCoord, int> >("FlatHashMap<GeoCoord, int>", coords, missingCoords, rounds);
+
+    vector<GeoKey> keys, missingKeys;
+    for(int i = 0; i < numKeys; i++){
+        keys.push_back(GeoKey());
+        missingKeys.push_back(GeoKey());
+        makeGeoKey(coords[i].latitudeText, coords[i].longitudeText, keys.back());
+        makeGeoKey(missingCoords[i].latitudeText, missingCoords[i].longitudeText, missingKeys.back());
+    }
+    benchmarkMap<FlatHashMap<GeoKey, int> >("FlatHashMap<GeoKey, int>", keys, missingKeys, rounds);
+    return 0;
+}
+
+  // deterministic random node pairs from the loaded map
+void samplePairs(const StreetMap& sm, int count, vector<GeoCoord>& starts, vector<GeoCoord>& ends)
+{
+    const StreetGraph& graph = sm.graph();
+    unsigned int state = 7;
+    for(int i = 0; i < count; i++){
+        starts.push_back(graph.coord(nextRandom(state) % graph.numNodes()));
+        ends.push_back(graph.coord(nextRandom(state) % graph.numNodes()));
+    }
+}
+
+  // a deterministic manifest: depot and stops at distinct candidate nodes, in shuffled order
+void sampleManifest(const StreetGraph& graph, vector<NodeID> candidates, int numStops, unsigned int& state, GeoCoord& depot, vector<DeliveryRequest>& deliveries)
+{
+    int n = candidates.size();
+    numStops = min(numStops, n - 1);
+    for(int i = 0; i <= numStops; i++){
+        swap(candidates[i], candidates[i + nextRandom(state) % (n - i)]);
+    }
+    depot = graph.coord(candidates[0]);
+    deliveries.clear();
+    for(int i = 1; i <= numStops; i++){
+        deliveries.push_back(DeliveryRequest("item" + to_string(i), graph.coord(candidates[i])));
+    }
+}
+
+vector<NodeID> allNodes(const StreetGraph& graph)
+{
+    vector<NodeID> nodes (graph.numNodes());
+    for(int i = 0; i < graph.numNodes(); i++){
+        nodes[i] = i;
+    }
+    return nodes;
+}
+
+  // the nodes of the largest connected piece of the map (every segment goes both ways), so every route between
+  // them exists
+vector<NodeID> largestComponent(const StreetGraph& graph)
+{
+    vector<int> component (graph.numNodes(), -1);
+    vector<NodeID> largest, current;
+    for(NodeID root = 0; root < graph.numNodes(); root++){
+        if(component[root] != -1){
+            continue;
+        }
+        current.assign(1, root);
+        component[root] = root;
+        for(size_t i = 0; i < current.size(); i++){
+            for(EdgeID e : graph.edgesFrom(current[i])){
+                NodeID v = graph.target(e);
+                if(component[v] == -1){
+                    component[v] = root;
+                    current.push_back(v);
+                }
+            }
+        }
+        if(current.size() > largest.size()){
+            largest.swap(current);
+        }
+    }
+    return largest;
+}
+
+void benchmarkRouter(const char* name, const StreetMap& sm, RouteAlgorithm algorithm, const vector<GeoCoord>& starts, const vector<GeoCoord>& ends)
+{
+    PointToPointRouter router(&sm, algorithm);
+    double seconds = 0, miles = 0;
+    long settled = 0;
+    int found = 0;
+    for(size_t i = 0; i < starts.size(); i++){
+        list<StreetSegment> route;
+        double distance = 0;
+        auto t = chrono::steady_clock::now();
+        DeliveryResult result = router.generatePointToPointRoute(starts[i], ends[i], route, distance);
+        seconds += secondsSince(t);
+
+        //the routers leave their counters in the calling thread's workspaces
+        settled += threadWorkspace(0).numSettled();
+        if(algorithm == ROUTE_BIDIRECTIONAL_ASTAR || algorithm == ROUTE_CONTRACTION_HIERARCHY){
+            settled += threadWorkspace(1).numSettled();
+        }
+        if(result == DELIVERY_SUCCESS){
+            found++;
+            miles += distance;
+        }
+    }
+    double n = starts.size();
+    printf("%-24s %9.1f us/query  %9.1f settled/query  %d routes, %.3f miles total\n",
+           name, seconds * 1e6 / n, settled / n, found, miles);
+}
+
+int benchmarkRoutes(const string& mapFile, int numQueries, int numLandmarks)
+{
+    StreetMap sm;
+    auto t = chrono::steady_clock::now();
+    if(!sm.load(mapFile)){
+        printf("Unable to load map data file %s\n", mapFile.c_str());
+        return 1;
+    }
+    printf("load: %.1f ms, %d nodes, %d edges\n", secondsSince(t) * 1e3, sm.graph().numNodes(), sm.graph().numEdges());
+
+    t = chrono::steady_clock::now();
+    sm.buildHierarchy();
+    printf("contraction: %.1f ms, %d arcs, %d triangles\n", secondsSince(t) * 1e3, sm.hierarchy()->numArcs(), sm.hierarchy()->numTriangles());
+
+    vector<GeoCoord> starts, ends;
+    samplePairs(sm, numQueries, starts, ends);
+
+    benchmarkRouter("A*", sm, ROUTE_ASTAR, starts, ends);
+    benchmarkRouter("bidirectional A*", sm, ROUTE_BIDIRECTIONAL_ASTAR, starts, ends);
+    benchmarkRouter("contraction hierarchy", sm, ROUTE_CONTRACTION_HIERARCHY, starts, ends);
+
+    t = chrono::steady_clock::now();
+    sm.buildLandmarks(numLandmarks, LANDMARKS_FARTHEST);
+    printf("landmarks (farthest): %.1f ms, %d landmarks, %.2f MB\n", secondsSince(t) * 1e3, sm.landmarks()->numLandmarks(), sm.landmarks()->memoryUsage() / 1048576.0);
+    benchmarkRouter("ALT (farthest)", sm, ROUTE_ALT, starts, ends);
+
+    t = chrono::steady_clock::now();
+    sm.buildLandmarks(numLandmarks, LANDMARKS_AVOID);
+    printf("landmarks (avoid): %.1f ms, %d landmarks, %.2f MB\n", secondsSince(t) * 1e3, sm.landmarks()->numLandmarks(), sm.landmarks()->memoryUsage() / 1048576.0);
+    benchmarkRouter("ALT (avoid)", sm, ROUTE_ALT, starts, ends);
+    return 0;
+}
+
+  // worst disagreement between two n x n tables, relative to the scalar one (absolute below a meter)
+double worstError(const vector<double>& reference, const vector<double>& kernel)
+{
+    double worst = 0;
+    for(size_t i = 0; i < reference.size(); i++){
+        double error = fabs(kernel[i] - reference[i]) / max(reference[i], 1e-3);
+        worst = max(worst, error);
+    }
+    return worst;
+}
+
+int benchmarkCrow(const string& mapFile, int numPoints)
+{
+    StreetMap sm;
+    if(!sm.load(mapFile)){
+        printf("Unable to load map data file %s\n", mapFile.c_str());
+        return 1;
+    }
+    const StreetGraph& graph = sm.graph();
+
+    //map nodes, the optimizer's and the heuristic's case
+    vector<GeoCoord> coords;
+    unsigned int state = 11;
+    for(int i = 0; i < numPoints; i++){
+        coords.push_back(graph.coord(nextRandom(state) % graph.numNodes()));
+    }
+    GeoPoints points;
+    for(size_t i = 0; i < coords.size(); i++){
+        points.add(coords[i]);
+    }
+
+    int n = coords.size();
+    vector<double> reference(n * n), kernel(n * n);
+    auto t = chrono::steady_clock::now();
+    for(int i = 0; i < n; i++){
+        for(int j = 0; j < n; j++){
+            reference[i * n + j] = distanceEarthKM(coords[i], coords[j]);
+        }
+    }
+    double scalarTime = secondsSince(t);
+    t = chrono::steady_clock::now();
+    crowDistanceMatrixKM(points, kernel.data());
+    double kernelTime = secondsSince(t);
+    double mapError = worstError(reference, kernel);
+    printf("%d x %d map nodes: distanceEarthKM %.2f ns/pair, kernel %.2f ns/pair (%.1fx), worst relative error %.3g\n",
+           n, n, scalarTime * 1e9 / (n * n), kernelTime * 1e9 / (n * n), scalarTime / kernelTime, mapError);
+
+    //anywhere on the globe, so the long-distance fallback is exercised as well
+    vector<GeoCoord> global;
+    GeoPoints globalPoints;
+    for(int i = 0; i < 500; i++){
+        double lat = (nextRandom(state) % 1800000) / 10000.0 - 90;
+        double lon = (nextRandom(state) % 3600000) / 10000.0 - 180;
+        global.push_back(GeoCoord(to_string(lat), to_string(lon)));
+        globalPoints.add(global.back());
+    }
+    int m = global.size();
+    reference.assign(m * m, 0);
+    kernel.assign(m * m, 0);
+    for(int i = 0; i < m; i++){
+        for(int j = 0; j < m; j++){
+            reference[i * m + j] = distanceEarthKM(global[i], global[j]);
+        }
+    }
+    crowDistanceMatrixKM(globalPoints, kernel.data());
+    double globalError = worstError(reference, kernel);
+    printf("%d x %d points worldwide: worst relative error %.3g\n", m, m, globalError);
+
+    bool passed = mapError <= 1e-9 && globalError <= 1e-9;
+    printf("accuracy check %s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
+
+int benchmarkTours(const string& mapFile, const vector<int>& sizes)
+{
+    StreetMap sm;
+    if(!sm.load(mapFile)){
+        printf("Unable to load map data file %s\n", mapFile.c_str());
+        return 1;
+    }
+    const StreetGraph& graph = sm.graph();
+    DeliveryOptimizer optimizer(&sm);
+    const double milesPerKm = 1 / 1.609344;
+
+    for(size_t s = 0; s < sizes.size(); s++){
+        unsigned int state = 13;
+        GeoCoord depot;
+        vector<DeliveryRequest> deliveries;
+        sampleManifest(graph, allNodes(graph), sizes[s], state, depot, deliveries);
+        int numStops = deliveries.size();
+        GeoPoints points;
+        points.add(depot);
+        for(int i = 0; i < numStops; i++){
+            points.add(deliveries[i].location);
+        }
+
+        double oldMiles = 0, newMiles = 0;
+        auto t = chrono::steady_clock::now();
+        optimizer.optimizeDeliveryOrder(depot, deliveries, oldMiles, newMiles);
+        double optimizerTime = secondsSince(t);
+
+        vector<int> order (numStops);
+        for(int i = 0; i < numStops; i++){
+            order[i] = i + 1;
+        }
+        NeighborListSearch search (points, milesPerKm);
+        t = chrono::steady_clock::now();
+        double searchMiles = search.improve(order);
+        double searchTime = secondsSince(t);
+
+        printf("%5d stops: given %9.2f miles  DeliveryOptimizer %9.2f miles in %8.1f ms  NeighborListSearch %9.2f miles in %8.1f ms\n",
+               numStops, oldMiles, newMiles, optimizerTime * 1e3, searchMiles, searchTime * 1e3);
+    }
+    return 0;
+}
+
+int benchmarkSnap(const string& mapFile, int numPoints)
+{
+    StreetMap sm;
+    auto t = chrono::steady_clock::now();
+    if(!sm.load(mapFile)){
+        printf("Unable to load map data file %s\n", mapFile.c_str());
+        return 1;
+    }
+    printf("load (with spatial index): %.1f ms\n", secondsSince(t) * 1e3);
+    const StreetGraph& graph = sm.graph();
+    const SpatialIndex& index = sm.spatialIndex();
+
+    //points jittered up to a few hundred meters off random nodes, as geocoded addresses are
+    unsigned int state = 17;
+    vector<GeoCoord> coords;
+    for(int i = 0; i < numPoints; i++){
+        NodeID n = nextRandom(state) % graph.numNodes();
+        double lat = graph.latitude(n) + (int(nextRandom(state) % 6001) - 3000) * 1e-6;
+        double lon = graph.longitude(n) + (int(nextRandom(state) % 6001) - 3000) * 1e-6;
+        coords.push_back(GeoCoord(to_string(lat), to_string(lon)));
+    }
+
+    long checksum = 0;
+    t = chrono::steady_clock::now();
+    for(size_t i = 0; i < coords.size(); i++){
+        checksum += index.nearestNode(coords[i].latitude, coords[i].longitude);
+    }
+    double nodeTime = secondsSince(t);
+    t = chrono::steady_clock::now();
+    for(size_t i = 0; i < coords.size(); i++){
+        double fraction;
+        checksum += index.nearestSegment(coords[i].latitude, coords[i].longitude, fraction);
+    }
+    double segmentTime = secondsSince(t);
+    vector<GeoCoord> vertices;
+    t = chrono::steady_clock::now();
+    sm.snapToNodes(coords, vertices);
+    double batchTime = secondsSince(t);
+
+    printf("nearest node %.0f ns/query, nearest segment %.0f ns/query, snapToNodes %.0f coordinates/s (checksum %ld)\n",
+           nodeTime * 1e9 / numPoints, segmentTime * 1e9 / numPoints, numPoints / batchTime, checksum);
+    return 0;
+}
+
+  // the map repeated copies times, copy k moved k half degrees north with " k" added to its street names
+bool writeEnlargedMap(const string& mapFile, const string& outFile, int copies)
+{
+    ifstream in(mapFile);
+    vector<string> lines;
+    string line;
+    while(getline(in, line)){
+        lines.push_back(line);
+    }
+    ofstream out(outFile);
+    if(lines.empty() || !out){
+        return false;
+    }
+    for(int k = 0; k < copies; k++){
+        int32_t shift = k * GEO_KEY_UNITS_PER_DEGREE / 2;
+        size_t i = 0;
+        while(i + 1 < lines.size() && lines[i] != ""){
+            int count = atoi(lines[i + 1].c_str());
+            out << lines[i] << (k > 0 ? " " + to_string(k) : "") << '\n' << count << '\n';
+            for(int j = 0; j < count && i + 2 + j < lines.size(); j++){
+                istringstream fields(lines[i + 2 + j]);
+                string text[4];
+                fields >> text[0] >> text[1] >> text[2] >> text[3];
+                for(int f = 0; f < 4; f++){
+                    int32_t value;
+                    char formatted[16];
+                    if(!parseFixed7(text[f].data(), text[f].size(), value)){
+                        return false;
+                    }
+                    out.write(formatted, formatFixed7(f % 2 == 0 ? value + shift : value, formatted));
+                    out << (f < 3 ? ' ' : '\n');
+                }
+            }
+            i += 2 + count;
+        }
+    }
+    return bool(out);
+}
+
+size_t fileSize(const string& file)
+{
+    ifstream in(file, ios::binary | ios::ate);
+    return in ? (size_t)in.tellg() : 0;
+}
+
+  // seconds, or -1 if the file doesn't load
+double bestLoadTime(const string& file, int rounds)
+{
+    double best = -1;
+    for(int r = 0; r < rounds; r++){
+        StreetMap sm;
+        auto t = chrono::steady_clock::now();
+        if(!sm.load(file)){
+            return -1;
+        }
+        double time = secondsSince(t);
+        if(best < 0 || time < best){
+            best = time;
+        }
+    }
+    return best;
+}
+
+int benchmarkLoad(const string& mapFile, int copies)
+{
+    string largeFile = mapFile + ".x" + to_string(copies) + ".tmp";
+    if(!writeEnlargedMap(mapFile, largeFile, copies)){
+        printf("Unable to read %s or write %s\n", mapFile.c_str(), largeFile.c_str());
+        return 1;
+    }
+    string files[] = {mapFile, largeFile};
+    int status = 0;
+    for(const string& file : files){
+        string imageFile = file + ".image.tmp";
+        StreetMap sm;
+        double textTime = bestLoadTime(file, 3);
+        double imageTime = -1;
+        if(textTime >= 0 && sm.load(file) && sm.saveImage(imageFile)){
+            imageTime = bestLoadTime(imageFile, 3);
+        }
+        remove(imageFile.c_str());
+        if(textTime < 0 || imageTime < 0){
+            printf("Unable to load %s\n", file.c_str());
+            status = 1;
+            continue;
+        }
+        double megabytes = fileSize(file) / 1e6;
+        printf("%s: %.1f MB, %d nodes, %d edges: text %.1f ms (%.0f MB/s), compiled image %.1f ms\n",
+               file.c_str(), megabytes, sm.graph().numNodes(), sm.graph().numEdges(), textTime * 1e3, megabytes / textTime, imageTime * 1e3);
+    }
+    remove(largeFile.c_str());
+    return status;
+}
+
+  // one line of the suite's CSV output: latency percentiles (nearest rank) of the samples, in seconds, and
+  // throughput in operations per second with threads running them at once
+void reportLatencies(const string& operation, const string& variant, vector<double>& seconds, int failures, int threads, double throughput)
+{
+    sort(seconds.begin(), seconds.end());
+    int n = seconds.size();
+    auto percentile = [&](double p) { return n == 0 ? 0 : seconds[max(0, (int)ceil(p * n) - 1)] * 1e3; };
+    double mean = 0;
+    for(int i = 0; i < n; i++){
+        mean += seconds[i] * 1e3 / n;
+    }
+    printf("%s,%s,%d,%d,%.4f,%.4f,%.4f,%.4f,%d,%.2f\n",
+           operation.c_str(), variant.c_str(), n, failures, percentile(0.5), percentile(0.95), percentile(0.99), mean, threads, throughput);
+    fflush(stdout);
+}
+
+  // times task(i) for every i one at a time for the latencies, then all of them again spread over the shared
+  // pool for the throughput; task returns false for a failed operation
+template<typename Task>
+void measure(const string& operation, const string& variant, int count, const Task& task)
+{
+    vector<double> seconds (count);
+    int failures = 0;
+    for(int i = 0; i < count; i++){
+        auto t = chrono::steady_clock::now();
+        failures += !task(i);
+        seconds[i] = secondsSince(t);
+    }
+    auto t = chrono::steady_clock::now();
+    sharedWorkerPool().parallelFor(count, [&](int i){ task(i); });
+    double wall = secondsSince(t);
+    reportLatencies(operation, variant, seconds, failures, sharedWorkerPool().numThreads(), wall > 0 ? count / wall : 0);
+}
+
+int benchmarkSuite(const string& mapFile, int numQueries, int numManifests, const vector<int>& sizes)
+{
+    printf("operation,variant,samples,failures,p50_ms,p95_ms,p99_ms,mean_ms,threads,ops_per_s\n");
+
+    //loads one after another, since concurrent ones would only measure the disk
+    const int numLoads = 5;
+    vector<double> loadSeconds;
+    double loadTotal = 0;
+    int loadFailures = 0;
+    for(int i = 0; i < numLoads; i++){
+        StreetMap sm;
+        auto t = chrono::steady_clock::now();
+        loadFailures += !sm.load(mapFile);
+        loadSeconds.push_back(secondsSince(t));
+        loadTotal += loadSeconds.back();
+    }
+    reportLatencies("load", "text", loadSeconds, loadFailures, 1, numLoads / loadTotal);
+    StreetMap sm;
+    if(loadFailures > 0 || !sm.load(mapFile)){
+        fprintf(stderr, "Unable to load map data file %s\n", mapFile.c_str());
+        return 1;
+    }
+    sm.buildHierarchy();
+    sm.buildLandmarks(8);
+    const StreetGraph& graph = sm.graph();
+
+    //every pair and manifest within one connected piece, so failures mean something is wrong
+    vector<NodeID> connected = largestComponent(graph);
+    unsigned int state = 7;
+    vector<GeoCoord> starts, ends;
+    for(int i = 0; i < numQueries; i++){
+        starts.push_back(graph.coord(connected[nextRandom(state) % connected.size()]));
+        ends.push_back(graph.coord(connected[nextRandom(state) % connected.size()]));
+    }
+    const RouteAlgorithm algorithms[] = {ROUTE_ASTAR, ROUTE_BIDIRECTIONAL_ASTAR, ROUTE_CONTRACTION_HIERARCHY, ROUTE_ALT};
+    const char* algorithmNames[] = {"astar", "bidirectional", "ch", "alt"};
+    for(int a = 0; a < 4; a++){
+        PointToPointRouter router(&sm, algorithms[a]);
+        measure("route", algorithmNames[a], numQueries, [&](int i){
+            list<StreetSegment> route;
+            double miles;
+            return router.generatePointToPointRoute(starts[i], ends[i], route, miles) == DELIVERY_SUCCESS;
+        });
+    }
+
+    DeliveryOptimizer optimizer(&sm);
+    DeliveryPlanner planner(&sm, ROUTE_CONTRACTION_HIERARCHY);
+    for(size_t s = 0; s < sizes.size(); s++){
+        state = 19 + sizes[s];
+        vector<GeoCoord> depots (numManifests);
+        vector<vector<DeliveryRequest> > manifests (numManifests);
+        for(int m = 0; m < numManifests; m++){
+            sampleManifest(graph, connected, sizes[s], state, depots[m], manifests[m]);
+        }
+        string variant = to_string(sizes[s]) + " stops";
+        measure("optimize", variant, numManifests, [&](int m){
+            vector<DeliveryRequest> deliveries (manifests[m]);
+            double oldMiles, newMiles;
+            optimizer.optimizeDeliveryOrder(depots[m], deliveries, oldMiles, newMiles);
+            return true;
+        });
+        measure("plan", variant, numManifests, [&](int m){
+            vector<DeliveryCommand> commands;
+            double miles = 0;
+            return planner.generateDeliveryPlan(depots[m], manifests[m], commands, miles) == DELIVERY_SUCCESS;
+        });
+    }
+    return 0;
+}
+
+void usage(const char* program)
+{
+    printf("Usage: %s hashmap [numKeys]\n", program);
+    printf("       %s route mapFile [numQueries] [numLandmarks]\n", program);
+    printf("       %s crow mapFile [numPoints]\n", program);
+    printf("       %s tour mapFile [numStops ...]\n", program);
+    printf("       %s snap mapFile [numPoints]\n", program);
+    printf("       %s load mapFile [copies]\n", program);
+    printf("       %s suite mapFile [numQueries] [numManifests] [numStops ...]\n", program);
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    string what = argv[1];
+    if (what == "hashmap")
+        return benchmarkHashMaps(argc > 2 ? atoi(argv[2]) : 100000);
+    if (what == "route" && argc > 2)
+        return benchmarkRoutes(argv[2], argc > 3 ? atoi(argv[3]) : 1000, argc > 4 ? atoi(argv[4]) : 8);
+    if (what == "crow" && argc > 2)
+        return benchmarkCrow(argv[2], argc > 3 ? atoi(argv[3]) : 1000);
+    if (what == "tour" && argc > 2)
+    {
+        vector<int> sizes;
+        for (int i = 3; i < argc; i++)
+            sizes.push_back(atoi(argv[i]));
+        if (sizes.empty())
+            sizes = {100, 1000, 5000};
+        return benchmarkTours(argv[2], sizes);
+    }
+
+    if (what == "snap" && argc > 2)
+        return benchmarkSnap(argv[2], argc > 3 ? atoi(argv[3]) : 100000);
+    if (what == "load" && argc > 2)
+        return benchmarkLoad(argv[2], argc > 3 ? atoi(argv[3]) : 50);
+    if (what == "suite" && argc > 2)
+    {
+        vector<int> sizes;
+        for (int i = 5; i < argc; i++)
+            sizes.push_back(atoi(argv[i]));
+        if (sizes.empty())
+            sizes = {10, 50};
+        return benchmarkSuite(argv[2], argc > 3 ? atoi(argv[3]) : 1000, argc > 4 ? atoi(argv[4]) : 50, sizes);
+    }
+
+    usage(argv[0]);
+    return 1;
+}
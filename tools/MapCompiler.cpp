@@ -0,0 +1,32 @@
+// MapCompiler.cpp
+// Offline step that turns a text map into a binary map image, so that later
+// runs can StreetMap::load the image without parsing anything.
+//
+//     MapCompiler mapdata.txt mapdata.smap
+
+#include "../provided.h"
+#include <iostream>
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3)
+    {
+        cout << "Usage: " << argv[0] << " mapdata.txt mapdata.smap" << endl;
+        return 1;
+    }
+
+    StreetMap sm;
+    if (!sm.load(argv[1]))
+    {
+        cout << "Unable to load map data file " << argv[1] << endl;
+        return 1;
+    }
+
+    if (!sm.saveImage(argv[2]))
+    {
+        cout << "Unable to write map image " << argv[2] << endl;
+        return 1;
+    }
+    cout << "Wrote " << argv[2] << endl;
+}